@@ -0,0 +1,639 @@
+// generates 360 and 90 degree difficulties for a whole song library, using every core
+// usage: generator-batch <library> [--threads n] [--force] [--based-on characteristic] [--spin] [--walls] [--one-saber] [--left-handed]
+// every folder with an Info.dat is a map, the generated files are written next to the original ones and added to the Info.dat
+// as 360Degree and 90Degree sets, a map that comes with its own set of one of them keeps it
+// maps that didn't change since the last run with the same settings are skipped
+
+#include "json.hpp"
+#include "core/beatmapfile.hpp"
+#include "core/generator.hpp"
+#include "core/hash.hpp"
+#include "core/threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Generator;
+
+// increase whenever the generated files change, so every map is generated again
+constexpr uint32_t BatchVersion = 6;
+
+// written in each map folder, holds the hash of everything the generated files were made from
+constexpr char const* StampName = ".360ifyer";
+
+struct Options {
+    std::string basedOn = "Standard";
+    int threads = 0;
+    bool force = false;
+    bool enableSpin = false;
+    bool wallGenerator = false;
+    bool onlyOneSaber = false;
+    bool leftHanded = false;
+};
+
+struct Mode {
+    bool is90Degree;
+    // characteristic of the generated set, one the game knows so the files can be played without the mod
+    // not the -Generated ones of the mod, its transform hook would rotate those maps again
+    char const* characteristic;
+    // of the generated file names, which also tells generated sets apart from ones that came with the map
+    char const* prefix;
+};
+
+constexpr Mode Modes[] = {
+    {false, "360Degree", "Generated360"},
+    {true, "90Degree", "Generated90"},
+};
+
+// the config defaults, apart from the options
+static Params GetParams(Options const& options, float bpm, bool is90Degree) {
+    Params params{};
+    params.bpm = bpm;
+    params.leftHanded = options.leftHanded;
+    if (is90Degree) {
+        params.rotationLimit = 2;
+        params.bottleneckRotations = 1;
+    }
+    params.enableSpin = options.enableSpin;
+    params.wallGenerator = options.wallGenerator;
+    params.onlyOneSaber = options.onlyOneSaber;
+    return params;
+}
+
+static std::optional<std::string> ReadFile(fs::path const& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad())
+        return std::nullopt;
+    return text;
+}
+
+// written to a temporary file first, so an interrupted run never leaves half a file
+static bool WriteFile(fs::path const& path, std::string_view text) {
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(text.data(), text.size());
+        file.close();
+        if (!file)
+            return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    return !error;
+}
+
+// keys of the fields the generator uses, for both versions of the difficulty format
+struct Format {
+    char const* time;
+    char const* lineIndex;
+    char const* lineLayer;
+    char const* duration;
+    char const* width;
+    // lists with notes and bombs, v3 has them separately
+    std::vector<char const*> noteLists;
+    char const* walls;
+};
+
+static Format const V2Format = {"_time", "_lineIndex", "_lineLayer", "_duration", "_width", {"_notes"}, "_obstacles"};
+static Format const V3Format = {"b", "x", "y", "d", "w", {"colorNotes", "bombNotes"}, "obstacles"};
+
+// where a note came from in the document
+struct Source {
+    int list;
+    int index;
+};
+
+// a difficulty file and the notes and walls in it, sorted by time like the game does
+struct Beatmap {
+    Json::Value document;
+    bool v3;
+    Tempo tempo;
+    std::vector<Note> notes;
+    std::vector<Wall> walls;
+    std::vector<Source> noteSources;
+    std::vector<int> wallSources;
+};
+
+static bool ReadNote(Json::Value const& item, bool v3, bool bombList, Tempo const& tempo, Note& note) {
+    auto& format = v3 ? V3Format : V2Format;
+    if (item.type != Json::Type::Object)
+        return false;
+    note.time = tempo.ToSeconds(item.GetNumber(format.time));
+    note.lineIndex = item.GetNumber(format.lineIndex);
+    note.lineLayer = (LineLayer) item.GetNumber(format.lineLayer);
+
+    int type = v3 ? (bombList ? 3 : item.GetNumber("c")) : item.GetNumber("_type");
+    if (type == 3) {
+        note.colorType = ColorType::None;
+        note.cutDirection = CutDirection::None;
+        return true;
+    }
+    // v2 type 2 was never used
+    if (type != 0 && type != 1)
+        return false;
+    note.colorType = (ColorType) type;
+    note.cutDirection = (CutDirection) item.GetNumber(v3 ? "d" : "_cutDirection");
+    return true;
+}
+
+static bool ReadWall(Json::Value const& item, bool v3, Tempo const& tempo, Wall& wall) {
+    auto& format = v3 ? V3Format : V2Format;
+    if (item.type != Json::Type::Object)
+        return false;
+    double time = item.GetNumber(format.time);
+    wall.time = tempo.ToSeconds(time);
+    wall.duration = tempo.ToSeconds(time + item.GetNumber(format.duration)) - wall.time;
+    wall.lineIndex = item.GetNumber(format.lineIndex);
+    wall.width = item.GetNumber(format.width);
+    if (v3) {
+        wall.lineLayer = (LineLayer) item.GetNumber("y");
+        wall.height = item.GetNumber("h");
+    } else {
+        // the same as the game converts full height and crouch walls
+        bool top = item.GetNumber("_type") == 1;
+        wall.lineLayer = top ? LineLayer::Top : LineLayer::Base;
+        wall.height = top ? 3 : 5;
+    }
+    return true;
+}
+
+// the times are floats in seconds, rounded so walls that didn't move keep their numbers
+static double Round(double beats) {
+    return std::round(beats * 10000) / 10000;
+}
+
+static double ToBeats(float time, Tempo const& tempo) {
+    return Round(tempo.ToBeats(time));
+}
+
+// the end is converted too, the bpm can change while the wall lasts
+static double DurationToBeats(float time, float duration, Tempo const& tempo) {
+    return Round(tempo.ToBeats((double) time + duration) - tempo.ToBeats(time));
+}
+
+static Json::Value WriteWall(Wall const& wall, bool v3, Tempo const& tempo) {
+    auto& format = v3 ? V3Format : V2Format;
+    auto item = Json::Value::Object();
+    item.Set(format.time, ToBeats(wall.time, tempo));
+    item.Set(format.lineIndex, wall.lineIndex);
+    if (v3)
+        item.Set("y", (int) wall.lineLayer);
+    else
+        item.Set("_type", wall.lineLayer == LineLayer::Top ? 1 : 0);
+    item.Set(format.duration, DurationToBeats(wall.time, wall.duration, tempo));
+    item.Set(format.width, wall.width);
+    if (v3)
+        item.Set("h", wall.height);
+    return item;
+}
+
+// nullopt if the file can't be parsed or has a format without rotation events
+static std::optional<Beatmap> LoadBeatmap(std::string_view text, float bpm) {
+    auto document = Json::Parse(text);
+    if (!document || document->type != Json::Type::Object)
+        return std::nullopt;
+
+    auto version = document->GetString("version");
+    if (version.starts_with("4"))
+        return std::nullopt;
+    bool v3 = version.starts_with("3") || document->Find("colorNotes");
+
+    // bpm changes are v3 bpm events or v2 events of type 100
+    std::vector<BpmChange> changes{};
+    if (auto events = document->Find(v3 ? "bpmEvents" : "_events"); events && events->type == Json::Type::Array) {
+        for (auto& event : events->array) {
+            if (v3)
+                changes.push_back({(float) event.GetNumber("b"), (float) event.GetNumber("m")});
+            else if (event.GetNumber("_type") == 100)
+                changes.push_back({(float) event.GetNumber("_time"), (float) event.GetNumber("_floatValue")});
+        }
+    }
+
+    Beatmap beatmap{std::move(*document), v3, Tempo(bpm, std::move(changes))};
+    auto& format = beatmap.v3 ? V3Format : V2Format;
+
+    std::vector<Note> notes{};
+    std::vector<Source> noteSources{};
+    for (int list = 0; list < format.noteLists.size(); list++) {
+        auto items = beatmap.document.Find(format.noteLists[list]);
+        if (!items || items->type != Json::Type::Array)
+            continue;
+        for (int i = 0; i < items->array.size(); i++) {
+            Note note;
+            if (ReadNote(items->array[i], beatmap.v3, list == 1, beatmap.tempo, note)) {
+                notes.push_back(note);
+                noteSources.push_back({list, i});
+            }
+        }
+    }
+    std::vector<Wall> walls{};
+    std::vector<int> wallSources{};
+    if (auto items = beatmap.document.Find(format.walls); items && items->type == Json::Type::Array) {
+        for (int i = 0; i < items->array.size(); i++) {
+            Wall wall;
+            if (ReadWall(items->array[i], beatmap.v3, beatmap.tempo, wall)) {
+                walls.push_back(wall);
+                wallSources.push_back(i);
+            }
+        }
+    }
+
+    std::vector<int> order(notes.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&notes](int a, int b) { return notes[a].time < notes[b].time; });
+    for (int i : order) {
+        beatmap.notes.push_back(notes[i]);
+        beatmap.noteSources.push_back(noteSources[i]);
+    }
+
+    order.resize(walls.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&walls](int a, int b) { return walls[a].time < walls[b].time; });
+    for (int i : order) {
+        beatmap.walls.push_back(walls[i]);
+        beatmap.wallSources.push_back(wallSources[i]);
+    }
+    return beatmap;
+}
+
+// the document with the edits of the result, removed items are set to null and then dropped
+static Json::Value ApplyResult(Beatmap const& beatmap, Result const& result, int numberOfLines) {
+    auto& format = beatmap.v3 ? V3Format : V2Format;
+    auto& tempo = beatmap.tempo;
+    auto document = beatmap.document;
+
+    // v2 has the rotation as a value from 0 to 7 for -60 to 60 degrees, v3 has it in degrees
+    char const* eventsKey = beatmap.v3 ? "rotationEvents" : "_events";
+    // added before looking up any list, adding members moves the others
+    for (auto key : {format.walls, eventsKey}) {
+        if (auto list = document.Find(key); !list || list->type != Json::Type::Array)
+            document.Set(key, Json::Value::Array());
+    }
+    auto walls = document.Find(format.walls);
+    auto events = document.Find(eventsKey);
+
+    auto NoteItem = [&](int index) -> Json::Value& {
+        auto source = beatmap.noteSources[index];
+        return document.Find(format.noteLists[source.list])->array[source.index];
+    };
+
+    for (int index : result.mirroredNotes) {
+        auto note = beatmap.notes[index];
+        Mirror(note, numberOfLines);
+        auto& item = NoteItem(index);
+        item.Set(format.lineIndex, note.lineIndex);
+        if (note.colorType != ColorType::None) {
+            item.Set(beatmap.v3 ? "c" : "_type", (int) note.colorType);
+            item.Set(beatmap.v3 ? "d" : "_cutDirection", (int) note.cutDirection);
+        }
+    }
+    for (int index : result.removedNotes)
+        NoteItem(index) = Json::Value();
+
+    for (auto& change : result.changedWalls) {
+        auto& item = walls->array[beatmap.wallSources[change.index]];
+        item.Set(format.time, ToBeats(change.time, tempo));
+        item.Set(format.duration, DurationToBeats(change.time, change.duration, tempo));
+    }
+    for (int index : result.removedWalls)
+        walls->array[beatmap.wallSources[index]] = Json::Value();
+    for (auto& wall : result.generatedWalls)
+        walls->array.push_back(WriteWall(wall, beatmap.v3, tempo));
+    for (auto& wall : result.splitWalls)
+        walls->array.push_back(WriteWall(wall, beatmap.v3, tempo));
+
+    for (auto& rotation : result.rotations) {
+        auto event = Json::Value::Object();
+        if (beatmap.v3) {
+            event.Set("b", ToBeats(rotation.time, tempo));
+            event.Set("e", rotation.early ? 0 : 1);
+            event.Set("r", rotation.amount * 15);
+        } else {
+            event.Set("_time", ToBeats(rotation.time, tempo));
+            event.Set("_type", rotation.early ? 14 : 15);
+            event.Set("_value", rotation.amount < 0 ? rotation.amount + 4 : rotation.amount + 3);
+        }
+        events->array.push_back(std::move(event));
+    }
+
+    auto Finish = [](Json::Value& list, char const* timeKey) {
+        std::erase_if(list.array, [](auto& item) { return item.type == Json::Type::Null; });
+        std::stable_sort(list.array.begin(), list.array.end(), [timeKey](auto& a, auto& b) { return a.GetNumber(timeKey) < b.GetNumber(timeKey); });
+    };
+    for (auto list : format.noteLists) {
+        if (auto notes = document.Find(list); notes && notes->type == Json::Type::Array)
+            Finish(*notes, format.time);
+    }
+    Finish(*walls, format.time);
+    Finish(*events, format.time);
+    return document;
+}
+
+struct Totals {
+    std::atomic<int> generated = 0;
+    std::atomic<int> upToDate = 0;
+    std::atomic<int> skipped = 0;
+    std::atomic<int> failed = 0;
+    std::atomic<int> difficulties = 0;
+};
+
+// a map being generated, the difficulties are separate jobs and the last one to finish updates the Info.dat
+struct MapJob {
+    fs::path folder;
+    fs::path infoPath;
+    Json::Value info;
+    int baseSet;
+    float bpm;
+    uint64_t inputHash;
+    // false for modes the map already has a set of that didn't come from this tool
+    std::vector<char> modes;
+    std::vector<std::string> files;
+    std::vector<char> succeeded;
+    std::atomic<int> remaining;
+};
+
+static fs::path GeneratedFile(std::string const& file, Mode const& mode) {
+    fs::path path(file);
+    return path.parent_path() / (mode.prefix + path.filename().string());
+}
+
+// a set of the characteristic of the mode that was written by this tool, all its files have the prefix
+static bool IsGeneratedSet(Json::Value const& set, Mode const& mode) {
+    if (set.GetString("_beatmapCharacteristicName") != mode.characteristic)
+        return false;
+    auto difficulties = set.Find("_difficultyBeatmaps");
+    if (!difficulties || difficulties->type != Json::Type::Array)
+        return true;
+    return std::all_of(difficulties->array.begin(), difficulties->array.end(), [&mode](auto& difficulty) {
+        return fs::path(difficulty.GetString("_beatmapFilename")).filename().string().starts_with(mode.prefix);
+    });
+}
+
+static void FinishMap(MapJob& job, Totals& totals) {
+    auto sets = job.info.Find("_difficultyBeatmapSets");
+    auto base = sets->array[job.baseSet];
+    std::erase_if(sets->array, [](auto& set) {
+        return std::any_of(std::begin(Modes), std::end(Modes), [&set](auto& mode) { return IsGeneratedSet(set, mode); });
+    });
+
+    auto difficulties = base.Find("_difficultyBeatmaps");
+    bool any = false;
+    for (int m = 0; m < std::size(Modes); m++) {
+        auto& mode = Modes[m];
+        if (!job.modes[m])
+            continue;
+        auto set = Json::Value::Object();
+        set.Set("_beatmapCharacteristicName", mode.characteristic);
+        auto& generated = set.Set("_difficultyBeatmaps", Json::Value::Array());
+        for (int i = 0; i < job.files.size(); i++) {
+            if (!job.succeeded[i])
+                continue;
+            auto difficulty = difficulties->array[i];
+            difficulty.Set("_beatmapFilename", GeneratedFile(job.files[i], mode).generic_string());
+            generated.array.push_back(std::move(difficulty));
+            any = true;
+        }
+        sets->array.push_back(std::move(set));
+    }
+
+    bool complete = std::all_of(job.succeeded.begin(), job.succeeded.end(), [](char succeeded) { return succeeded; });
+    if (!any || !WriteFile(job.infoPath, Json::Write(job.info))) {
+        fprintf(stderr, "%s: could not write Info.dat\n", job.folder.c_str());
+        totals.failed++;
+        return;
+    }
+    // without a stamp, the map is tried again next time
+    if (complete) {
+        char stamp[32];
+        snprintf(stamp, sizeof(stamp), "%016" PRIx64, job.inputHash);
+        WriteFile(job.folder / StampName, stamp);
+    }
+    if (complete)
+        totals.generated++;
+    else
+        totals.failed++;
+}
+
+static void GenerateDifficulty(std::shared_ptr<MapJob> job, int index, std::string text, Options const& options, Totals& totals) {
+    auto beatmap = LoadBeatmap(text, job->bpm);
+    text = {};
+    bool succeeded = beatmap.has_value();
+
+    // both modes from one analysis of the notes
+    std::vector<Params> variants{};
+    for (auto& mode : Modes)
+        variants.push_back(GetParams(options, job->bpm, mode.is90Degree));
+    std::vector<Result> results{};
+    if (succeeded)
+        results = GenerateVariants(beatmap->notes, beatmap->walls, variants);
+
+    for (int i = 0; i < std::size(Modes) && succeeded; i++) {
+        if (!job->modes[i])
+            continue;
+        auto document = ApplyResult(*beatmap, results[i], variants[i].numberOfLines);
+        succeeded = WriteFile(job->folder / GeneratedFile(job->files[index], Modes[i]), Json::Write(document));
+    }
+    if (succeeded)
+        totals.difficulties++;
+    else
+        fprintf(stderr, "%s: could not generate %s\n", job->folder.c_str(), job->files[index].c_str());
+
+    job->succeeded[index] = succeeded;
+    if (--job->remaining == 0)
+        FinishMap(*job, totals);
+}
+
+static void GenerateMap(fs::path folder, fs::path infoPath, Options const& options, ThreadPool& pool, Totals& totals) {
+    auto Fail = [&](char const* reason) {
+        fprintf(stderr, "%s: %s\n", folder.c_str(), reason);
+        totals.failed++;
+    };
+
+    auto text = ReadFile(infoPath);
+    auto info = text ? Json::Parse(*text) : std::nullopt;
+    if (!info || info->type != Json::Type::Object)
+        return Fail("could not read Info.dat");
+
+    float bpm = info->GetNumber("_beatsPerMinute");
+    auto sets = info->Find("_difficultyBeatmapSets");
+    if (bpm <= 0 || !sets || sets->type != Json::Type::Array)
+        return Fail("unsupported Info.dat");
+
+    int baseSet = -1;
+    for (int i = 0; i < sets->array.size(); i++) {
+        if (sets->array[i].GetString("_beatmapCharacteristicName") == options.basedOn)
+            baseSet = i;
+    }
+    auto difficulties = baseSet >= 0 ? sets->array[baseSet].Find("_difficultyBeatmaps") : nullptr;
+    if (!difficulties || difficulties->type != Json::Type::Array || difficulties->array.empty())
+        return Fail("no difficulties to generate from");
+
+    // everything the generated files depend on
+    Hasher hasher{};
+    hasher.Add(BatchVersion);
+    hasher.Add(options.basedOn);
+    hasher.Add(options.enableSpin);
+    hasher.Add(options.wallGenerator);
+    hasher.Add(options.onlyOneSaber);
+    hasher.Add(options.leftHanded);
+    hasher.Add(bpm);
+
+    std::vector<std::string> files{};
+    std::vector<std::string> texts{};
+    for (auto& difficulty : difficulties->array) {
+        auto& file = files.emplace_back(difficulty.GetString("_beatmapFilename"));
+        auto text = ReadFile(folder / file);
+        if (file.empty() || !text)
+            return Fail("missing difficulty file");
+        hasher.Add(file);
+        hasher.Add(*text);
+        texts.push_back(std::move(*text));
+    }
+
+    // a map can come with its own 360 or 90 degree set, which is kept and not generated
+    std::vector<char> modes{};
+    for (auto& mode : Modes) {
+        bool own = std::any_of(sets->array.begin(), sets->array.end(), [&mode](auto& set) {
+            return set.GetString("_beatmapCharacteristicName") == mode.characteristic && !IsGeneratedSet(set, mode);
+        });
+        modes.push_back(!own);
+        hasher.Add(own);
+    }
+    if (std::none_of(modes.begin(), modes.end(), [](char enabled) { return enabled; })) {
+        totals.skipped++;
+        return;
+    }
+
+    if (!options.force) {
+        char stamp[32];
+        snprintf(stamp, sizeof(stamp), "%016" PRIx64, hasher.Get());
+        bool upToDate = ReadFile(folder / StampName) == std::string(stamp);
+        for (auto& file : files) {
+            for (int m = 0; m < std::size(Modes); m++)
+                upToDate = upToDate && (!modes[m] || fs::exists(folder / GeneratedFile(file, Modes[m])));
+        }
+        if (upToDate) {
+            totals.upToDate++;
+            return;
+        }
+    }
+
+    auto job = std::make_shared<MapJob>();
+    job->folder = std::move(folder);
+    job->infoPath = std::move(infoPath);
+    job->info = std::move(*info);
+    job->baseSet = baseSet;
+    job->bpm = bpm;
+    job->inputHash = hasher.Get();
+    job->modes = std::move(modes);
+    job->files = std::move(files);
+    job->succeeded.resize(job->files.size());
+    job->remaining = job->files.size();
+
+    // large maps are split over several workers
+    for (int i = 0; i < job->files.size(); i++) {
+        pool.Submit([job, i, text = std::move(texts[i]), &options, &totals]() mutable {
+            GenerateDifficulty(job, i, std::move(text), options, totals);
+        });
+    }
+}
+
+static std::optional<fs::path> FindInfo(fs::path const& folder) {
+    for (auto name : {"Info.dat", "info.dat"}) {
+        std::error_code error;
+        if (fs::is_regular_file(folder / name, error))
+            return folder / name;
+    }
+    return std::nullopt;
+}
+
+int main(int argc, char** argv) {
+    Options options{};
+    char const* library = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+            options.threads = atoi(argv[++i]);
+        else if (arg == "--based-on" && i + 1 < argc)
+            options.basedOn = argv[++i];
+        else if (arg == "--force")
+            options.force = true;
+        else if (arg == "--spin")
+            options.enableSpin = true;
+        else if (arg == "--walls")
+            options.wallGenerator = true;
+        else if (arg == "--one-saber")
+            options.onlyOneSaber = true;
+        else if (arg == "--left-handed")
+            options.leftHanded = true;
+        else if (!library && !arg.starts_with("--"))
+            library = argv[i];
+        else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!library) {
+        fprintf(stderr, "usage: generator-batch <library> [--threads n] [--force] [--based-on characteristic] [--spin] [--walls] [--one-saber] [--left-handed]\n");
+        return 2;
+    }
+
+    // the library itself can also be a single map
+    std::vector<std::pair<fs::path, fs::path>> maps{};
+    std::error_code error;
+    if (auto info = FindInfo(library))
+        maps.emplace_back(library, *info);
+    else {
+        for (auto it = fs::recursive_directory_iterator(library, error); !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_directory())
+                continue;
+            if (auto info = FindInfo(it->path())) {
+                maps.emplace_back(it->path(), *info);
+                it.disable_recursion_pending();
+            }
+        }
+    }
+    if (error) {
+        fprintf(stderr, "could not read %s: %s\n", library, error.message().c_str());
+        return 1;
+    }
+
+    Totals totals{};
+    auto start = std::chrono::steady_clock::now();
+    int threads;
+    {
+        ThreadPool pool(options.threads);
+        threads = pool.GetThreadCount();
+        for (auto& [folder, info] : maps) {
+            pool.Submit([&pool, &options, &totals, folder, info]() {
+                GenerateMap(folder, info, options, pool, totals);
+            });
+        }
+        pool.Wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%zu maps: %d generated, %d up to date, %d with their own sets, %d failed\n", maps.size(), totals.generated.load(), totals.upToDate.load(),
+        totals.skipped.load(), totals.failed.load());
+    printf("%d difficulties in %.2f s with %d threads, %.1f maps per second\n", totals.difficulties.load(), seconds, threads, maps.size() / seconds);
+    return totals.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+// measures generation time per map without the game
+// usage: generator-benchmark [minutes] [bpm] [iterations]
+//        generator-benchmark <difficulty.dat> <bpm> [iterations]
+
+#include "core/beatmapfile.hpp"
+#include "core/generator.hpp"
+#include "core/stats.hpp"
+#include "core/threadpool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace Generator;
+
+// deterministic pseudo random map, roughly a dense expert stream with some walls and bombs
+static void CreateMap(float minutes, float bpm, std::vector<Note>& notes, std::vector<Wall>& walls) {
+    uint32_t state = 360;
+    auto Random = [&state](int max) {
+        state = state * 1664525 + 1013904223;
+        return (int) ((state >> 8) % max);
+    };
+
+    float beatDuration = 60 / bpm;
+    int beats = minutes * 60 / beatDuration;
+    for (int beat = 0; beat < beats; beat++) {
+        for (int sub = 0; sub < 4; sub++) {
+            if (Random(4) == 0)
+                continue;
+            float time = (beat + sub * 0.25f) * beatDuration;
+            int notesAtTime = Random(3) == 0 ? 2 : 1;
+            for (int n = 0; n < notesAtTime; n++) {
+                bool bomb = Random(16) == 0;
+                notes.push_back({
+                    time,
+                    Random(4),
+                    (LineLayer) Random(3),
+                    bomb ? ColorType::None : (ColorType) Random(2),
+                    bomb ? CutDirection::None : (CutDirection) Random(9)
+                });
+            }
+        }
+        if (Random(8) == 0)
+            walls.push_back({beat * beatDuration, beatDuration * (1 + Random(4)), Random(4), LineLayer::Base, 1 + Random(2), 5});
+    }
+}
+
+int main(int argc, char** argv) {
+    bool fromFile = argc > 1 && std::string_view(argv[1]).ends_with(".dat");
+    float minutes = argc > 1 && !fromFile ? atof(argv[1]) : 5;
+    float bpm = argc > 2 ? atof(argv[2]) : 150;
+    int iterations = argc > 3 ? atoi(argv[3]) : 20;
+
+    std::vector<Note> notes{};
+    std::vector<Wall> walls{};
+    if (fromFile) {
+        auto file = ReadBeatmapFile(argv[1]);
+        if (!file) {
+            printf("could not read %s\n", argv[1]);
+            return 1;
+        }
+        ConvertToSeconds(*file, bpm);
+        notes = std::move(file->notes);
+        walls = std::move(file->walls);
+        printf("map: %s, %.0f bpm, %zu notes, %zu walls\n", argv[1], bpm, notes.size(), walls.size());
+    } else {
+        CreateMap(minutes, bpm, notes, walls);
+        printf("map: %.1f minutes, %.0f bpm, %zu notes, %zu walls\n", minutes, bpm, notes.size(), walls.size());
+    }
+
+    for (bool is90Degree : {false, true}) {
+        for (bool extras : {false, true}) {
+            Params params{};
+            params.bpm = bpm;
+            if (is90Degree) {
+                params.rotationLimit = 2;
+                params.bottleneckRotations = 1;
+            }
+            params.enableSpin = extras;
+            params.wallGenerator = extras;
+            params.onlyOneSaber = extras;
+
+            size_t rotations = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+                rotations = Generate(notes, walls, params).rotations.size();
+            auto end = std::chrono::steady_clock::now();
+
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+            printf("%s degree%s: %.3f ms per map (%zu rotations)\n", is90Degree ? "90" : "360", extras ? " + spin/walls/one saber" : "", ms, rotations);
+
+            // timed separately so the timers don't affect the total above
+            StatsHistory history{};
+            for (int i = 0; i < iterations; i++) {
+                Stats stats{};
+                Generate(notes, walls, params, &stats);
+                history.Add(stats);
+            }
+            printf("  %s\n", FormatStats(history.Average()).c_str());
+        }
+    }
+
+    // both modes from one analysis, compared to generating them one after the other
+    for (bool extras : {false, true}) {
+        Params variants[2]{};
+        for (auto& params : variants) {
+            params.bpm = bpm;
+            params.enableSpin = extras;
+            params.wallGenerator = extras;
+            params.onlyOneSaber = extras;
+        }
+        variants[1].rotationLimit = 2;
+        variants[1].bottleneckRotations = 1;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (auto& params : variants)
+                Generate(notes, walls, params);
+        }
+        auto separate = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            GenerateVariants(notes, walls, variants);
+        auto shared = std::chrono::steady_clock::now() - start;
+
+        printf("360 and 90 degree%s: %.3f ms per map, %.3f ms separately\n", extras ? " + spin/walls/one saber" : "",
+            std::chrono::duration<double, std::milli>(shared).count() / iterations, std::chrono::duration<double, std::milli>(separate).count() / iterations);
+    }
+
+    // scaling with a pool: the bars are analyzed on it, then chunks of bars are decided on it and joined in order
+    // the speedup is against the serial generation, the redecided bars are the ones a chunk had to decide again at its start
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    printf("scaling, %u cores:\n", cores);
+    for (bool is90Degree : {false, true}) {
+        for (bool extras : {false, true}) {
+            Params params{};
+            params.bpm = bpm;
+            if (is90Degree) {
+                params.rotationLimit = 2;
+                params.bottleneckRotations = 1;
+            }
+            params.enableSpin = extras;
+            params.wallGenerator = extras;
+            params.onlyOneSaber = extras;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+                Generate(notes, walls, params);
+            double serial = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+            printf("  %s degree%s: %.3f ms serially\n", is90Degree ? "90" : "360", extras ? " + spin/walls/one saber" : "", serial);
+
+            for (unsigned threads = 1; threads <= std::max(cores, 8u); threads *= 2) {
+                ThreadPool pool(threads);
+                Stats stats{};
+                Generate(notes, walls, params, &stats, &pool);
+
+                start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; i++)
+                    Generate(notes, walls, params, nullptr, &pool);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+                printf("    %2u threads: %.3f ms, %.2fx, %d redecided bars\n", threads, ms, serial / ms, stats.redecidedBars);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include "json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace Json {
+    Value* Value::Find(std::string_view key) {
+        for (auto& member : object) {
+            if (member.key == key)
+                return &member.value;
+        }
+        return nullptr;
+    }
+
+    Value const* Value::Find(std::string_view key) const {
+        return const_cast<Value*>(this)->Find(key);
+    }
+
+    Value& Value::Set(std::string_view key, Value value) {
+        if (auto existing = Find(key))
+            return *existing = std::move(value);
+        object.push_back({std::string(key), std::move(value)});
+        return object.back().value;
+    }
+
+    bool Value::Remove(std::string_view key) {
+        return std::erase_if(object, [key](auto& member) { return member.key == key; }) > 0;
+    }
+
+    double Value::GetNumber(std::string_view key, double fallback) const {
+        auto value = Find(key);
+        return value && value->type == Type::Number ? value->number : fallback;
+    }
+
+    std::string_view Value::GetString(std::string_view key, std::string_view fallback) const {
+        auto value = Find(key);
+        return value && value->type == Type::String ? std::string_view(value->string) : fallback;
+    }
+
+    // deeper documents are rejected instead of overflowing the stack
+    constexpr int MaxDepth = 256;
+
+    struct Parser {
+        char const* position;
+        char const* end;
+
+        void SkipWhitespace() {
+            while (position < end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r'))
+                position++;
+        }
+
+        bool Consume(std::string_view word) {
+            if (end - position < (ptrdiff_t) word.size() || std::string_view(position, word.size()) != word)
+                return false;
+            position += word.size();
+            return true;
+        }
+
+        static void AppendUtf8(std::string& string, uint32_t code) {
+            if (code < 0x80)
+                string += (char) code;
+            else if (code < 0x800) {
+                string += (char) (0xC0 | (code >> 6));
+                string += (char) (0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                string += (char) (0xE0 | (code >> 12));
+                string += (char) (0x80 | ((code >> 6) & 0x3F));
+                string += (char) (0x80 | (code & 0x3F));
+            } else {
+                string += (char) (0xF0 | (code >> 18));
+                string += (char) (0x80 | ((code >> 12) & 0x3F));
+                string += (char) (0x80 | ((code >> 6) & 0x3F));
+                string += (char) (0x80 | (code & 0x3F));
+            }
+        }
+
+        bool ParseHex(uint32_t& code) {
+            if (end - position < 4)
+                return false;
+            auto result = std::from_chars(position, position + 4, code, 16);
+            if (result.ptr != position + 4)
+                return false;
+            position += 4;
+            return true;
+        }
+
+        bool ParseString(std::string& string) {
+            // the opening quote was already checked
+            position++;
+            while (position < end) {
+                char c = *position++;
+                if (c == '"')
+                    return true;
+                if ((unsigned char) c < 0x20)
+                    return false;
+                if (c != '\\') {
+                    string += c;
+                    continue;
+                }
+                if (position == end)
+                    return false;
+                switch (*position++) {
+                    case '"': string += '"'; break;
+                    case '\\': string += '\\'; break;
+                    case '/': string += '/'; break;
+                    case 'b': string += '\b'; break;
+                    case 'f': string += '\f'; break;
+                    case 'n': string += '\n'; break;
+                    case 'r': string += '\r'; break;
+                    case 't': string += '\t'; break;
+                    case 'u': {
+                        uint32_t code;
+                        if (!ParseHex(code))
+                            return false;
+                        // surrogate pair
+                        if (code >= 0xD800 && code < 0xDC00) {
+                            uint32_t low;
+                            if (!Consume("\\u") || !ParseHex(low) || low < 0xDC00 || low >= 0xE000)
+                                return false;
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        AppendUtf8(string, code);
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            return false;
+        }
+
+        bool ParseNumber(double& number) {
+            // from_chars accepts a few forms json doesn't, like leading zeros, which is fine for reading
+            auto result = std::from_chars(position, end, number);
+            if (result.ec != std::errc() || !std::isfinite(number))
+                return false;
+            position = result.ptr;
+            return true;
+        }
+
+        bool ParseValue(Value& value, int depth) {
+            if (depth > MaxDepth)
+                return false;
+            SkipWhitespace();
+            if (position == end)
+                return false;
+
+            switch (*position) {
+                case 'n':
+                    return Consume("null");
+                case 't':
+                    value = Value(true);
+                    return Consume("true");
+                case 'f':
+                    value = Value(false);
+                    return Consume("false");
+                case '"':
+                    value.type = Type::String;
+                    return ParseString(value.string);
+                case '[': {
+                    value.type = Type::Array;
+                    position++;
+                    SkipWhitespace();
+                    if (position < end && *position == ']') {
+                        position++;
+                        return true;
+                    }
+                    while (true) {
+                        if (!ParseValue(value.array.emplace_back(), depth + 1))
+                            return false;
+                        SkipWhitespace();
+                        if (position == end)
+                            return false;
+                        char c = *position++;
+                        if (c == ']')
+                            return true;
+                        if (c != ',')
+                            return false;
+                    }
+                }
+                case '{': {
+                    value.type = Type::Object;
+                    position++;
+                    SkipWhitespace();
+                    if (position < end && *position == '}') {
+                        position++;
+                        return true;
+                    }
+                    while (true) {
+                        SkipWhitespace();
+                        if (position == end || *position != '"')
+                            return false;
+                        auto& member = value.object.emplace_back();
+                        if (!ParseString(member.key))
+                            return false;
+                        SkipWhitespace();
+                        if (!Consume(":") || !ParseValue(member.value, depth + 1))
+                            return false;
+                        SkipWhitespace();
+                        if (position == end)
+                            return false;
+                        char c = *position++;
+                        if (c == '}')
+                            return true;
+                        if (c != ',')
+                            return false;
+                    }
+                }
+                default:
+                    value.type = Type::Number;
+                    return ParseNumber(value.number);
+            }
+        }
+    };
+
+    std::optional<Value> Parse(std::string_view text) {
+        // utf-8 byte order mark, some map editors write it
+        if (text.starts_with("\xEF\xBB\xBF"))
+            text.remove_prefix(3);
+
+        Parser parser{text.data(), text.data() + text.size()};
+        Value value{};
+        if (!parser.ParseValue(value, 0))
+            return std::nullopt;
+        parser.SkipWhitespace();
+        if (parser.position != parser.end)
+            return std::nullopt;
+        return value;
+    }
+
+    static void WriteString(std::string& out, std::string_view string) {
+        out += '"';
+        for (char c : string) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char) c < 0x20) {
+                        char escape[8];
+                        snprintf(escape, sizeof(escape), "\\u%04x", c);
+                        out += escape;
+                    } else
+                        out += c;
+            }
+        }
+        out += '"';
+    }
+
+    static void WriteValue(std::string& out, Value const& value) {
+        switch (value.type) {
+            case Type::Null:
+                out += "null";
+                break;
+            case Type::Bool:
+                out += value.boolean ? "true" : "false";
+                break;
+            case Type::Number: {
+                char buffer[32];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), value.number);
+                out.append(buffer, result.ptr);
+                break;
+            }
+            case Type::String:
+                WriteString(out, value.string);
+                break;
+            case Type::Array:
+                out += '[';
+                for (size_t i = 0; i < value.array.size(); i++) {
+                    if (i > 0)
+                        out += ',';
+                    WriteValue(out, value.array[i]);
+                }
+                out += ']';
+                break;
+            case Type::Object:
+                out += '{';
+                for (size_t i = 0; i < value.object.size(); i++) {
+                    if (i > 0)
+                        out += ',';
+                    WriteString(out, value.object[i].key);
+                    out += ':';
+                    WriteValue(out, value.object[i].value);
+                }
+                out += '}';
+                break;
+        }
+    }
+
+    std::string Write(Value const& value) {
+        std::string out{};
+        WriteValue(out, value);
+        return out;
+    }
+}
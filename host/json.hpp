@@ -0,0 +1,64 @@
+#pragma once
+
+// small json document model for the host tools
+// object members keep their order, so rewritten files only differ where they were edited
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Json {
+    enum class Type : uint8_t {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    struct Member;
+
+    struct Value {
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<Value> array;
+        std::vector<Member> object;
+
+        Value() = default;
+        Value(bool boolean) : type(Type::Bool), boolean(boolean) {}
+        Value(double number) : type(Type::Number), number(number) {}
+        Value(int number) : type(Type::Number), number(number) {}
+        Value(std::string string) : type(Type::String), string(std::move(string)) {}
+        Value(char const* string) : type(Type::String), string(string) {}
+
+        static Value Array() { Value value; value.type = Type::Array; return value; }
+        static Value Object() { Value value; value.type = Type::Object; return value; }
+
+        // nullptr if this is not an object or has no such member
+        Value* Find(std::string_view key);
+        Value const* Find(std::string_view key) const;
+        // replaces the member if it exists, adds it to the end otherwise
+        Value& Set(std::string_view key, Value value);
+        bool Remove(std::string_view key);
+
+        // the fallback is used if the member is missing or of a different type
+        double GetNumber(std::string_view key, double fallback = 0) const;
+        std::string_view GetString(std::string_view key, std::string_view fallback = {}) const;
+    };
+
+    struct Member {
+        std::string key;
+        Value value;
+    };
+
+    // nullopt if the text is not a single valid json value
+    std::optional<Value> Parse(std::string_view text);
+
+    // without whitespace, numbers in the shortest form that reads back the same
+    std::string Write(Value const& value);
+}
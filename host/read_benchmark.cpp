@@ -0,0 +1,111 @@
+// measures how fast difficulty files are read, with the streaming reader and with a full json document for comparison
+// usage: generator-read-benchmark [files...]
+// without files, a long synthetic map is written in both formats to the temporary directory and read
+
+#include "json.hpp"
+#include "core/beatmapfile.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace Generator;
+
+// about 20 minutes of dense notes, with some custom data like modded maps have
+static std::string CreateMap(bool v3) {
+    uint32_t state = 360;
+    auto Random = [&state](int max) {
+        state = state * 1664525 + 1013904223;
+        return (int) ((state >> 8) % max);
+    };
+
+    std::string notes{};
+    std::string bombs{};
+    std::string walls{};
+    char item[256];
+    for (int beat = 0; beat < 3000; beat++) {
+        for (int sub = 0; sub < 4; sub++) {
+            if (Random(4) == 0)
+                continue;
+            double time = beat + sub * 0.25;
+            bool bomb = Random(16) == 0;
+            auto& list = v3 && bomb ? bombs : notes;
+            if (v3 && bomb)
+                snprintf(item, sizeof(item), R"({"b":%g,"x":%d,"y":%d})", time, Random(4), Random(3));
+            else if (v3)
+                snprintf(item, sizeof(item), R"({"b":%g,"x":%d,"y":%d,"a":0,"c":%d,"d":%d,"customData":{"color":[1,0.5,0.25]}})", time, Random(4), Random(3), Random(2), Random(9));
+            else
+                snprintf(item, sizeof(item), R"({"_time":%g,"_lineIndex":%d,"_lineLayer":%d,"_type":%d,"_cutDirection":%d,"_customData":{"_color":[1,0.5,0.25]}})",
+                    time, Random(4), Random(3), bomb ? 3 : Random(2), Random(9));
+            if (!list.empty())
+                list += ',';
+            list += item;
+        }
+        if (Random(8) == 0) {
+            if (v3)
+                snprintf(item, sizeof(item), R"({"b":%d,"x":%d,"y":0,"d":%d,"w":%d,"h":5})", beat, Random(4), 1 + Random(4), 1 + Random(2));
+            else
+                snprintf(item, sizeof(item), R"({"_time":%d,"_lineIndex":%d,"_type":0,"_duration":%d,"_width":%d})", beat, Random(4), 1 + Random(4), 1 + Random(2));
+            if (!walls.empty())
+                walls += ',';
+            walls += item;
+        }
+    }
+    if (v3)
+        return R"({"version":"3.2.0","colorNotes":[)" + notes + R"(],"bombNotes":[)" + bombs + R"(],"obstacles":[)" + walls + R"(],"basicBeatmapEvents":[]})";
+    return R"({"_version":"2.2.0","_notes":[)" + notes + R"(],"_obstacles":[)" + walls + R"(],"_events":[]})";
+}
+
+static std::string ReadFile(std::string const& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// runs the function for about a second and returns the time per call
+template<class F>
+static double Measure(F&& function) {
+    int iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start;
+    while (end - start < std::chrono::seconds(1)) {
+        function();
+        iterations++;
+        end = std::chrono::steady_clock::now();
+    }
+    return std::chrono::duration<double>(end - start).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths{};
+    for (int i = 1; i < argc; i++)
+        paths.push_back(argv[i]);
+
+    if (paths.empty()) {
+        for (bool v3 : {false, true}) {
+            auto path = (fs::temp_directory_path() / (v3 ? "generator-read-benchmark-v3.dat" : "generator-read-benchmark-v2.dat")).string();
+            std::ofstream(path, std::ios::binary) << CreateMap(v3);
+            paths.push_back(path);
+        }
+    }
+
+    for (auto& path : paths) {
+        auto file = ReadBeatmapFile(path);
+        if (!file) {
+            printf("%s: could not read\n", path.c_str());
+            continue;
+        }
+        double megabytes = fs::file_size(path) / (1024.0 * 1024.0);
+        printf("%s: %.1f MB, v%d, %zu notes, %zu walls\n", path.c_str(), megabytes, file->v3 ? 3 : 2, file->notes.size(), file->walls.size());
+
+        double streaming = Measure([&]() { file = ReadBeatmapFile(path); });
+        printf("  streaming: %.2f ms, %.0f MB/s\n", streaming * 1000, megabytes / streaming);
+
+        double document = Measure([&]() { auto parsed = Json::Parse(ReadFile(path)); });
+        printf("  document:  %.2f ms, %.0f MB/s\n", document * 1000, megabytes / document);
+    }
+}
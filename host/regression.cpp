@@ -0,0 +1,372 @@
+// runs every option combination over a corpus of synthetic stress maps and compares with the recorded golden results
+// usage: generator-regression <golden file> [--record] [--time-threshold factor] [--memory-threshold factor] [--repeat n]
+// fails if any result differs, also when generated with a thread pool, or if the time or peak memory of a map grew past the threshold times the recorded one
+// record again with --record after a change that is meant to change the results or the performance
+
+#include "core/generator.hpp"
+#include "core/hash.hpp"
+#include "core/threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+using namespace Generator;
+
+// heap in use by this program, to find the peak of each generation
+static std::atomic<size_t> heapBytes = 0;
+static std::atomic<size_t> peakHeapBytes = 0;
+
+void* operator new(size_t size) {
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    size_t bytes = heapBytes += malloc_usable_size(pointer);
+    size_t peak = peakHeapBytes;
+    while (bytes > peak && !peakHeapBytes.compare_exchange_weak(peak, bytes));
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (!pointer)
+        return;
+    heapBytes -= malloc_usable_size(pointer);
+    free(pointer);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+struct CorpusMap {
+    std::string name;
+    float bpm;
+    std::vector<Note> notes;
+    std::vector<Wall> walls;
+};
+
+class Random {
+    uint32_t state;
+
+    public:
+    Random(uint32_t seed) : state(seed) {}
+
+    int operator()(int max) {
+        state = state * 1664525 + 1013904223;
+        return (int) ((state >> 8) % max);
+    }
+};
+
+static Note RandomNote(Random& random, float time, bool bomb = false) {
+    return {
+        time,
+        random(4),
+        (LineLayer) random(3),
+        bomb ? ColorType::None : (ColorType) random(2),
+        bomb ? CutDirection::None : (CutDirection) random(9)
+    };
+}
+
+static void SortWalls(std::vector<Wall>& walls) {
+    std::stable_sort(walls.begin(), walls.end(), [](auto& a, auto& b) { return a.time < b.time; });
+}
+
+// 16th notes with up to four notes at once, the bars of 8 beats are mostly over the 58 notes where no rotations are made
+static CorpusMap DenseStream() {
+    CorpusMap map{"dense-stream", 200};
+    Random random(1);
+    float beatDuration = 60 / map.bpm;
+    for (int bar = 0; bar < 132; bar++) {
+        // bars of 128 and 64 notes, and every count from 16 to 72 to cross all the divider limits
+        int section = bar % 4;
+        int count = section == 0 ? 128 : section == 1 ? 16 + bar / 4 : section == 2 ? 40 + bar / 4 : 64;
+        for (int sub = 0; sub < 32; sub++) {
+            float time = (bar * 8 + sub * 0.25f) * beatDuration;
+            int notesAtTime = count / 32 + (sub < count % 32 ? 1 : 0);
+            for (int n = 0; n < notesAtTime; n++)
+                map.notes.push_back(RandomNote(random, time));
+        }
+        if (bar % 2 == 0)
+            map.walls.push_back({bar * 8 * beatDuration, beatDuration * 8, random(2) * 3, LineLayer::Base, 1, 5});
+    }
+    return map;
+}
+
+// more than 10000 overlapping walls of all sizes between a normal stream
+static CorpusMap ManyWalls() {
+    CorpusMap map{"many-walls", 150};
+    Random random(2);
+    float beatDuration = 60 / map.bpm;
+    for (int beat = 0; beat < 1500; beat++) {
+        for (int sub = 0; sub < 2; sub++) {
+            if (random(3) > 0)
+                map.notes.push_back(RandomNote(random, (beat + sub * 0.5f) * beatDuration));
+        }
+        for (int i = 0; i < 8; i++) {
+            float time = (beat + i * 0.125f) * beatDuration;
+            bool top = random(3) == 0;
+            map.walls.push_back({time, beatDuration * (0.25f + random(16) * 0.5f), random(4), top ? LineLayer::Top : LineLayer::Base, 1 + random(2), top ? 3 : 5});
+        }
+    }
+    SortWalls(map.walls);
+    return map;
+}
+
+// 20 minutes of an expert stream
+static CorpusMap Marathon() {
+    CorpusMap map{"marathon", 140};
+    Random random(3);
+    float beatDuration = 60 / map.bpm;
+    int beats = 20 * 60 / beatDuration;
+    for (int beat = 0; beat < beats; beat++) {
+        for (int sub = 0; sub < 4; sub++) {
+            if (random(4) == 0)
+                continue;
+            float time = (beat + sub * 0.25f) * beatDuration;
+            int notesAtTime = random(3) == 0 ? 2 : 1;
+            for (int n = 0; n < notesAtTime; n++)
+                map.notes.push_back(RandomNote(random, time, random(16) == 0));
+        }
+        if (random(8) == 0)
+            map.walls.push_back({beat * beatDuration, beatDuration * (1 + random(4)), random(4), LineLayer::Base, 1 + random(2), 5});
+    }
+    return map;
+}
+
+// more bombs than notes, in every lane around the notes
+static CorpusMap Bombs() {
+    CorpusMap map{"bombs", 128};
+    Random random(4);
+    float beatDuration = 60 / map.bpm;
+    for (int beat = 0; beat < 800; beat++) {
+        for (int sub = 0; sub < 4; sub++) {
+            float time = (beat + sub * 0.25f) * beatDuration;
+            if (random(2) == 0)
+                map.notes.push_back(RandomNote(random, time));
+            int bombs = random(5);
+            for (int n = 0; n < bombs; n++)
+                map.notes.push_back(RandomNote(random, time, true));
+        }
+        if (random(6) == 0)
+            map.walls.push_back({beat * beatDuration, beatDuration * 2, random(4), LineLayer::Base, 1, 5});
+    }
+    return map;
+}
+
+// chords alone in their bar with pauses between them, which start spins
+static CorpusMap Spins() {
+    CorpusMap map{"spins", 100};
+    Random random(5);
+    float beatDuration = 60 / map.bpm;
+    for (int beat = 0; beat < 1200; beat += 4) {
+        if (random(3) == 0) {
+            // a normal bar between the chords
+            for (int sub = 0; sub < 8; sub++)
+                map.notes.push_back(RandomNote(random, (beat + sub * 0.5f) * beatDuration));
+            continue;
+        }
+        int notesAtTime = 2 + random(3);
+        for (int n = 0; n < notesAtTime; n++)
+            map.notes.push_back(RandomNote(random, beat * beatDuration));
+        if (random(2) == 0)
+            map.notes.push_back(RandomNote(random, beat * beatDuration, true));
+        if (random(4) == 0)
+            map.walls.push_back({beat * beatDuration, beatDuration * 3, random(4), LineLayer::Base, 1 + random(2), 5});
+    }
+    return map;
+}
+
+struct Options {
+    bool is90Degree;
+    bool enableSpin;
+    bool wallGenerator;
+    bool onlyOneSaber;
+    bool leftHanded;
+};
+
+static std::string OptionsName(Options const& options) {
+    std::string name = options.is90Degree ? "90" : "360";
+    if (options.enableSpin)
+        name += "-spin";
+    if (options.wallGenerator)
+        name += "-walls";
+    if (options.onlyOneSaber)
+        name += "-onesaber";
+    if (options.leftHanded)
+        name += "-left";
+    return name;
+}
+
+static std::vector<Options> AllOptions() {
+    std::vector<Options> all{};
+    for (int i = 0; i < 32; i++)
+        all.push_back({(i & 1) != 0, (i & 2) != 0, (i & 4) != 0, (i & 8) != 0, (i & 16) != 0});
+    return all;
+}
+
+static Params GetParams(CorpusMap const& map, Options const& options) {
+    Params params{};
+    params.bpm = map.bpm;
+    if (options.is90Degree) {
+        params.rotationLimit = 2;
+        params.bottleneckRotations = 1;
+    }
+    params.enableSpin = options.enableSpin;
+    params.wallGenerator = options.wallGenerator;
+    params.onlyOneSaber = options.onlyOneSaber;
+    params.leftHanded = options.leftHanded;
+    return params;
+}
+
+// lines of "result <map> <options> <hash>", "memory <map> <bytes>" and "time <map> <ms>"
+struct Golden {
+    std::map<std::string, uint64_t> results;
+    std::map<std::string, size_t> memory;
+    std::map<std::string, double> times;
+};
+
+static bool ReadGolden(char const* path, Golden& golden) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string type, name;
+        stream >> type >> name;
+        if (type == "result") {
+            std::string options, hash;
+            stream >> options >> hash;
+            golden.results[name + " " + options] = strtoull(hash.c_str(), nullptr, 16);
+        } else if (type == "memory")
+            stream >> golden.memory[name];
+        else if (type == "time")
+            stream >> golden.times[name];
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    char const* goldenPath = nullptr;
+    bool record = false;
+    double timeThreshold = 1.5;
+    double memoryThreshold = 1.2;
+    int repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--record"))
+            record = true;
+        else if (!strcmp(argv[i], "--time-threshold") && i + 1 < argc)
+            timeThreshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--memory-threshold") && i + 1 < argc)
+            memoryThreshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = std::max(1, atoi(argv[++i]));
+        else if (!goldenPath)
+            goldenPath = argv[i];
+    }
+    if (!goldenPath) {
+        printf("usage: generator-regression <golden file> [--record] [--time-threshold factor] [--memory-threshold factor] [--repeat n]\n");
+        return 2;
+    }
+
+    Golden golden{};
+    if (!record && !ReadGolden(goldenPath, golden)) {
+        printf("could not read %s, create it with --record\n", goldenPath);
+        return 1;
+    }
+
+    std::vector<CorpusMap> corpus{};
+    corpus.push_back(DenseStream());
+    corpus.push_back(ManyWalls());
+    corpus.push_back(Marathon());
+    corpus.push_back(Bombs());
+    corpus.push_back(Spins());
+
+    // for the results with chunks of bars decided in parallel, which must be the same
+    ThreadPool pool(3);
+
+    std::string recorded = "# generated by generator-regression --record\n";
+    int failures = 0;
+    char line[256];
+
+    for (auto& map : corpus) {
+        // the best of a few runs, the others are slowed down by something else
+        double bestTime = INFINITY;
+        size_t peakBytes = 0;
+
+        for (int run = 0; run < repeat; run++) {
+            double time = 0;
+            for (auto& options : AllOptions()) {
+                auto params = GetParams(map, options);
+
+                size_t baseBytes = heapBytes;
+                peakHeapBytes = baseBytes;
+                auto start = std::chrono::steady_clock::now();
+                auto result = Generate(map.notes, map.walls, params);
+                time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                peakBytes = std::max(peakBytes, peakHeapBytes - baseBytes);
+
+                if (run > 0)
+                    continue;
+                auto key = map.name + " " + OptionsName(options);
+                uint64_t hash = HashResult(result);
+                snprintf(line, sizeof(line), "result %s %016" PRIx64 "\n", key.c_str(), hash);
+                recorded += line;
+                if (!record && golden.results[key] != hash) {
+                    printf("%s: result changed\n", key.c_str());
+                    failures++;
+                }
+                if (!record && HashResult(Generate(map.notes, map.walls, params, nullptr, &pool)) != hash) {
+                    printf("%s: result with a pool differs\n", key.c_str());
+                    failures++;
+                }
+            }
+            bestTime = std::min(bestTime, time);
+        }
+
+        printf("%s: %zu notes, %zu walls, %.2f ms for all options, peak %.1f KB\n",
+            map.name.c_str(), map.notes.size(), map.walls.size(), bestTime, peakBytes / 1024.0);
+        snprintf(line, sizeof(line), "memory %s %zu\ntime %s %.3f\n", map.name.c_str(), peakBytes, map.name.c_str(), bestTime);
+        recorded += line;
+
+        if (record)
+            continue;
+        if (!golden.memory.contains(map.name) || !golden.times.contains(map.name)) {
+            printf("%s: not in the golden file\n", map.name.c_str());
+            failures++;
+            continue;
+        }
+        if (peakBytes > golden.memory[map.name] * memoryThreshold) {
+            printf("%s: peak memory %zu is over %.2f times the recorded %zu\n", map.name.c_str(), peakBytes, memoryThreshold, golden.memory[map.name]);
+            failures++;
+        }
+        if (bestTime > golden.times[map.name] * timeThreshold) {
+            printf("%s: time %.2f ms is over %.2f times the recorded %.2f ms\n", map.name.c_str(), bestTime, timeThreshold, golden.times[map.name]);
+            failures++;
+        }
+    }
+
+    if (record) {
+        std::ofstream(goldenPath) << recorded;
+        printf("recorded %s\n", goldenPath);
+        return 0;
+    }
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
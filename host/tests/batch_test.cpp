@@ -0,0 +1,94 @@
+// the batch tool must add sets the game can play to the Info.dat, and keep the ones that came with a map
+// usage: batch-test <generator-batch>
+
+#include "json.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+// a v2 difficulty with a note on every half beat
+static std::string CreateDifficulty() {
+    std::string notes{};
+    char item[128];
+    for (int i = 0; i < 400; i++) {
+        snprintf(item, sizeof(item), R"({"_time":%g,"_lineIndex":%d,"_lineLayer":0,"_type":%d,"_cutDirection":%d})", i * 0.5, i % 4, i % 2, (i * 3) % 8);
+        if (!notes.empty())
+            notes += ',';
+        notes += item;
+    }
+    return R"({"_version":"2.2.0","_notes":[)" + notes + R"(],"_obstacles":[],"_events":[]})";
+}
+
+static void WriteMap(fs::path const& folder, std::string const& sets) {
+    fs::create_directories(folder);
+    std::ofstream(folder / "Info.dat") << R"({"_version":"2.0.0","_beatsPerMinute":120,"_difficultyBeatmapSets":[)" << sets << "]}";
+    std::ofstream(folder / "ExpertPlus.dat") << CreateDifficulty();
+}
+
+static std::vector<std::pair<std::string, std::string>> ReadSets(fs::path const& folder) {
+    std::ifstream file(folder / "Info.dat");
+    auto info = Json::Parse(std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+    std::vector<std::pair<std::string, std::string>> sets{};
+    auto list = info ? info->Find("_difficultyBeatmapSets") : nullptr;
+    if (!list)
+        return sets;
+    for (auto& set : list->array) {
+        auto difficulties = set.Find("_difficultyBeatmaps");
+        std::string file = difficulties && !difficulties->array.empty() ? std::string(difficulties->array[0].GetString("_beatmapFilename")) : "";
+        sets.emplace_back(set.GetString("_beatmapCharacteristicName"), file);
+    }
+    return sets;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: batch-test <generator-batch>\n");
+        return 2;
+    }
+    auto library = fs::temp_directory_path() / "generator-batch-test";
+    fs::remove_all(library);
+
+    std::string standard = R"({"_beatmapCharacteristicName":"Standard","_difficultyBeatmaps":[{"_difficulty":"ExpertPlus","_difficultyRank":9,"_beatmapFilename":"ExpertPlus.dat"}]})";
+    std::string own = R"({"_beatmapCharacteristicName":"360Degree","_difficultyBeatmaps":[{"_difficulty":"Expert","_difficultyRank":7,"_beatmapFilename":"Mapped360.dat"}]})";
+    WriteMap(library / "plain", standard);
+    WriteMap(library / "own", standard + "," + own);
+
+    // the second run is forced, so the sets written by the first one must be replaced and not added again
+    auto command = std::string(argv[1]) + " " + library.string() + " --threads 2 > /dev/null";
+    for (auto extra : {"", " --force"}) {
+        CHECK(std::system((command + extra).c_str()) == 0);
+
+        auto plain = ReadSets(library / "plain");
+        CHECK(plain.size() == 3);
+        if (plain.size() == 3) {
+            CHECK(plain[0].first == "Standard" && plain[0].second == "ExpertPlus.dat");
+            CHECK(plain[1].first == "360Degree" && plain[1].second == "Generated360ExpertPlus.dat");
+            CHECK(plain[2].first == "90Degree" && plain[2].second == "Generated90ExpertPlus.dat");
+        }
+        CHECK(fs::exists(library / "plain" / "Generated360ExpertPlus.dat"));
+        CHECK(fs::exists(library / "plain" / "Generated90ExpertPlus.dat"));
+
+        auto withOwn = ReadSets(library / "own");
+        CHECK(withOwn.size() == 3);
+        if (withOwn.size() == 3) {
+            CHECK(withOwn[1].first == "360Degree" && withOwn[1].second == "Mapped360.dat");
+            CHECK(withOwn[2].first == "90Degree" && withOwn[2].second == "Generated90ExpertPlus.dat");
+        }
+        CHECK(!fs::exists(library / "own" / "Generated360ExpertPlus.dat"));
+    }
+
+    fs::remove_all(library);
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
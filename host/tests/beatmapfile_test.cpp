@@ -0,0 +1,133 @@
+// the streaming reader must find the same notes and walls as the game in both formats, whatever else is in the file
+
+#include "core/beatmapfile.hpp"
+
+#include <cstdio>
+#include <string>
+
+using namespace Generator;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+static bool NoteIs(Note const& note, float time, int lineIndex, LineLayer lineLayer, ColorType colorType, CutDirection cutDirection) {
+    return note.time == time && note.lineIndex == lineIndex && note.lineLayer == lineLayer && note.colorType == colorType && note.cutDirection == cutDirection;
+}
+
+static bool WallIs(Wall const& wall, float time, float duration, int lineIndex, LineLayer lineLayer, int width, int height) {
+    return wall.time == time && wall.duration == duration && wall.lineIndex == lineIndex && wall.lineLayer == lineLayer && wall.width == width && wall.height == height;
+}
+
+int main() {
+    // v2 with custom data that uses the same keys, escaped strings and fields in unusual order
+    auto v2 = ParseBeatmapFile(R"json(
+        {
+            "_version": "2.2.0",
+            "_customData": {"_notes": [{"_time": 99}], "_bookmarks": [{"_name": "a \"quoted\" ] name\\"}]},
+            "_events": [{"_time": 0, "_type": 1, "_value": 3}],
+            "_notes": [
+                {"_time": 1.5, "_lineIndex": 2, "_lineLayer": 1, "_type": 0, "_cutDirection": 1},
+                {"_cutDirection": 8, "_type": 1, "_lineLayer": 0, "_lineIndex": 3, "_time": 2e0, "_customData": {"_time": 7, "_position": [1, 2]}},
+                {"_time": 3, "_lineIndex": 0, "_lineLayer": 2, "_type": 3, "_cutDirection": 0},
+                {"_time": 4, "_lineIndex": 0, "_lineLayer": 0, "_type": 2, "_cutDirection": 0},
+                {"_time": 5, "_lineIndex": 1, "_type": 1, "_cutDirection": 4}
+            ],
+            "_obstacles": [
+                {"_time": 2, "_lineIndex": 0, "_type": 0, "_duration": 1.25, "_width": 2},
+                {"_time": 6, "_lineIndex": 3, "_type": 1, "_duration": -0.5, "_width": 1, "_customData": null}
+            ],
+            "_waypoints": []
+        }
+    )json");
+    CHECK(v2.has_value());
+    if (v2) {
+        CHECK(!v2->v3);
+        CHECK(v2->notes.size() == 4);
+        CHECK(v2->walls.size() == 2);
+        if (v2->notes.size() == 4) {
+            CHECK(NoteIs(v2->notes[0], 1.5, 2, LineLayer::Upper, ColorType::ColorA, CutDirection::Down));
+            CHECK(NoteIs(v2->notes[1], 2, 3, LineLayer::Base, ColorType::ColorB, CutDirection::Any));
+            CHECK(NoteIs(v2->notes[2], 3, 0, LineLayer::Top, ColorType::None, CutDirection::None));
+            // the unused type 2 is skipped, missing fields are 0
+            CHECK(NoteIs(v2->notes[3], 5, 1, LineLayer::Base, ColorType::ColorB, CutDirection::UpLeft));
+        }
+        if (v2->walls.size() == 2) {
+            CHECK(WallIs(v2->walls[0], 2, 1.25, 0, LineLayer::Base, 2, 5));
+            CHECK(WallIs(v2->walls[1], 6, -0.5, 3, LineLayer::Top, 1, 3));
+        }
+    }
+
+    // v3 with bombs in a separate list, and a top level version that comes last
+    auto v3 = ParseBeatmapFile("\xEF\xBB\xBF" R"json({
+        "bpmEvents": [{"b": 0, "m": 120}],
+        "obstacles": [{"b": 8, "x": 1, "y": 2, "d": 4, "w": 2, "h": 3}],
+        "colorNotes": [{"b": 1, "x": 0, "y": 0, "a": 45, "c": 1, "d": 7}, {"b": 0.5, "x": 3, "y": 2, "c": 0, "d": 0, "customData": {"color": [1, 0, 0]}}],
+        "bombNotes": [{"b": 1, "x": 2, "y": 1}],
+        "version": "3.3.0"
+    })json");
+    CHECK(v3.has_value());
+    if (v3) {
+        CHECK(v3->v3);
+        CHECK(v3->notes.size() == 3);
+        CHECK(v3->walls.size() == 1);
+        if (v3->notes.size() == 3) {
+            CHECK(NoteIs(v3->notes[0], 1, 0, LineLayer::Base, ColorType::ColorB, CutDirection::DownRight));
+            CHECK(NoteIs(v3->notes[1], 0.5, 3, LineLayer::Top, ColorType::ColorA, CutDirection::Up));
+            CHECK(NoteIs(v3->notes[2], 1, 2, LineLayer::Upper, ColorType::None, CutDirection::None));
+        }
+        if (v3->walls.size() == 1)
+            CHECK(WallIs(v3->walls[0], 8, 4, 1, LineLayer::Top, 2, 3));
+
+        // 120 bpm, sorted by time with the order of equal times kept
+        ConvertToSeconds(*v3, 120);
+        CHECK(v3->notes[0].time == 0.25f && v3->notes[0].lineIndex == 3);
+        CHECK(v3->notes[1].time == 0.5f && v3->notes[1].lineIndex == 0);
+        CHECK(v3->notes[2].time == 0.5f && v3->notes[2].lineIndex == 2);
+        CHECK(v3->walls[0].time == 4 && v3->walls[0].duration == 2);
+    }
+
+    // bpm changes, v2 as events of type 100 and v3 as bpm events, out of order and with one at beat 0
+    auto v2Bpm = ParseBeatmapFile(R"json({
+        "_version": "2.5.0",
+        "_events": [{"_time": 8, "_type": 100, "_value": 0, "_floatValue": 240}, {"_time": 2, "_type": 1, "_value": 60}, {"_time": 4, "_type": 100, "_value": 0, "_floatValue": 60}],
+        "_notes": [{"_time": 6, "_lineIndex": 0, "_lineLayer": 0, "_type": 0, "_cutDirection": 1}, {"_time": 10, "_lineIndex": 1, "_lineLayer": 0, "_type": 1, "_cutDirection": 1}],
+        "_obstacles": [{"_time": 2, "_lineIndex": 0, "_type": 0, "_duration": 4, "_width": 1}]
+    })json");
+    CHECK(v2Bpm && v2Bpm->bpmChanges.size() == 2);
+    if (v2Bpm && v2Bpm->notes.size() == 2 && v2Bpm->walls.size() == 1) {
+        // 120 bpm until beat 4, 60 until beat 8, then 240
+        ConvertToSeconds(*v2Bpm, 120);
+        CHECK(v2Bpm->notes[0].time == 4);
+        CHECK(v2Bpm->notes[1].time == 6.5f);
+        CHECK(v2Bpm->walls[0].time == 1 && v2Bpm->walls[0].duration == 3);
+    }
+    auto v3Bpm = ParseBeatmapFile(R"json({"version": "3.2.0", "bpmEvents": [{"b": 2, "m": 60}, {"b": 0, "m": 240}], "colorNotes": [{"b": 4, "c": 0, "d": 1}]})json");
+    CHECK(v3Bpm && v3Bpm->bpmChanges.size() == 2);
+    if (v3Bpm && v3Bpm->notes.size() == 1) {
+        ConvertToSeconds(*v3Bpm, 120);
+        CHECK(v3Bpm->notes[0].time == 2.5f);
+    }
+    Tempo tempo(120, {{4, 60}, {8, 240}});
+    CHECK(!tempo.IsConstant());
+    CHECK(tempo.ToBeats(4) == 6 && tempo.ToBeats(6.5) == 10 && tempo.ToBeats(-1) == -2);
+    CHECK(tempo.ToSeconds(-2) == -1);
+
+    // empty lists and no version
+    auto empty = ParseBeatmapFile(R"json({"_notes": [], "_obstacles": [ ], "_events": []})json");
+    CHECK(empty && !empty->v3 && empty->notes.empty() && empty->walls.empty());
+
+    // not supported or not valid
+    CHECK(!ParseBeatmapFile(R"json({"version": "4.0.0", "colorNotes": []})json"));
+    CHECK(!ParseBeatmapFile(""));
+    CHECK(!ParseBeatmapFile("[]"));
+    CHECK(!ParseBeatmapFile(R"json({"_notes": [{"_time": 1,}]})json"));
+    CHECK(!ParseBeatmapFile(R"json({"_notes": [{"_time": 1}])json"));
+    CHECK(!ParseBeatmapFile(R"json({"_notes": [{"_time": 1}]} trailing)json"));
+    CHECK(!ParseBeatmapFile(R"json({"_name": "unterminated})json"));
+    CHECK(!ReadBeatmapFile("/nonexistent/ExpertPlus.dat"));
+
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
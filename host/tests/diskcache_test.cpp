@@ -0,0 +1,172 @@
+// round trip and corruption handling of the on disk result cache
+
+#include "core/diskcache.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using namespace Generator;
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+static Result CreateResult() {
+    Result result{};
+    for (int i = 0; i < 100; i++)
+        result.rotations.push_back({i * 0.5f, i % 2 ? 1 : -2, i % 3 == 0});
+    result.removedNotes = {1, 5, 9};
+    result.mirroredNotes = {2, 3};
+    result.removedWalls = {4};
+    result.changedWalls.push_back({0, 1.5, 0.25});
+    result.generatedWalls.push_back({2, 1, 0, LineLayer::Top, 1, 1});
+    result.splitWalls.push_back({3, 0.5, 3, LineLayer::Base, 1, 3});
+    return result;
+}
+
+static bool Equal(Result const& a, Result const& b) {
+    if (a.rotations.size() != b.rotations.size())
+        return false;
+    for (int i = 0; i < a.rotations.size(); i++) {
+        if (a.rotations[i].time != b.rotations[i].time || a.rotations[i].amount != b.rotations[i].amount || a.rotations[i].early != b.rotations[i].early)
+            return false;
+    }
+    auto WallsEqual = [](std::vector<Wall> const& a, std::vector<Wall> const& b) {
+        if (a.size() != b.size())
+            return false;
+        for (int i = 0; i < a.size(); i++) {
+            if (a[i].time != b[i].time || a[i].duration != b[i].duration || a[i].lineIndex != b[i].lineIndex || a[i].lineLayer != b[i].lineLayer || a[i].width != b[i].width || a[i].height != b[i].height)
+                return false;
+        }
+        return true;
+    };
+    if (a.changedWalls.size() != b.changedWalls.size())
+        return false;
+    for (int i = 0; i < a.changedWalls.size(); i++) {
+        if (a.changedWalls[i].index != b.changedWalls[i].index || a.changedWalls[i].time != b.changedWalls[i].time || a.changedWalls[i].duration != b.changedWalls[i].duration)
+            return false;
+    }
+    return a.removedNotes == b.removedNotes && a.mirroredNotes == b.mirroredNotes && a.removedWalls == b.removedWalls &&
+        WallsEqual(a.generatedWalls, b.generatedWalls) && WallsEqual(a.splitWalls, b.splitWalls);
+}
+
+// changes one byte of the file
+static void Corrupt(std::string const& path, size_t offset) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(offset);
+    char byte = file.get();
+    file.seekp(offset);
+    file.put(byte ^ 0x5a);
+}
+
+int main() {
+    auto directory = fs::temp_directory_path() / "360ifyer-diskcache-test";
+    fs::remove_all(directory);
+
+    DiskCache cache(directory.string(), 1024 * 1024);
+    CacheKey key{"custom_level_ABCDEF", 4, "Standard", false, false, 1234};
+    uint64_t inputHash = 5678;
+    auto result = CreateResult();
+    auto path = cache.GetPath(key);
+
+    // round trip
+    CHECK(cache.Save(key, inputHash, result));
+    auto loaded = cache.Load(key, inputHash);
+    CHECK(loaded && Equal(*loaded, result));
+
+    // empty result
+    CacheKey emptyKey = key;
+    emptyKey.difficulty = 0;
+    CHECK(cache.Save(emptyKey, inputHash, Result{}));
+    loaded = cache.Load(emptyKey, inputHash);
+    CHECK(loaded && loaded->rotations.empty() && loaded->splitWalls.empty());
+
+    // missing file
+    CacheKey otherKey = key;
+    otherKey.is90Degree = true;
+    CHECK(!cache.Load(otherKey, inputHash));
+
+    // different notes are a miss, but the file is kept
+    CHECK(!cache.Load(key, inputHash + 1));
+    CHECK(fs::exists(path));
+
+    // settings hash in the header not matching the file name
+    CacheKey changedSettings = key;
+    changedSettings.settingsHash++;
+    fs::copy_file(path, cache.GetPath(changedSettings));
+    CHECK(!cache.Load(changedSettings, inputHash));
+    CHECK(!fs::exists(cache.GetPath(changedSettings)));
+
+    // version mismatch
+    CHECK(cache.Save(key, inputHash, result));
+    Corrupt(path, 4);
+    CHECK(!cache.Load(key, inputHash));
+    CHECK(!fs::exists(path));
+
+    // corrupted payload
+    CHECK(cache.Save(key, inputHash, result));
+    Corrupt(path, fs::file_size(path) - 10);
+    CHECK(!cache.Load(key, inputHash));
+    CHECK(!fs::exists(path));
+
+    // truncated file
+    CHECK(cache.Save(key, inputHash, result));
+    fs::resize_file(path, fs::file_size(path) - 12);
+    CHECK(!cache.Load(key, inputHash));
+    CHECK(!fs::exists(path));
+    CHECK(cache.Save(key, inputHash, result));
+    fs::resize_file(path, 0);
+    CHECK(!cache.Load(key, inputHash));
+    CHECK(!fs::exists(path));
+
+    // saved again after being rejected
+    CHECK(cache.Save(key, inputHash, result));
+    loaded = cache.Load(key, inputHash);
+    CHECK(loaded && Equal(*loaded, result));
+
+    // the pregeneration, a finished stream and the level load can save the same key at once
+    std::vector<std::thread> writers{};
+    std::atomic<int> failedSaves = 0;
+    for (int i = 0; i < 8; i++) {
+        writers.emplace_back([&]() {
+            for (int j = 0; j < 20; j++)
+                failedSaves += !cache.Save(key, inputHash, result);
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    CHECK(failedSaves == 0);
+    loaded = cache.Load(key, inputHash);
+    CHECK(loaded && Equal(*loaded, result));
+    bool temporaryLeft = false;
+    for (auto& entry : fs::directory_iterator(directory))
+        temporaryLeft |= entry.path().extension() == ".tmp";
+    CHECK(!temporaryLeft);
+
+    // eviction keeps the directory within the size limit, removing the least recently used files
+    size_t fileSize = fs::file_size(path);
+    DiskCache smallCache(directory.string(), fileSize * 3);
+    for (int i = 0; i < 6; i++) {
+        CacheKey evictKey = key;
+        evictKey.levelId += std::to_string(i);
+        CHECK(smallCache.Save(evictKey, inputHash, result));
+    }
+    size_t totalSize = 0;
+    for (auto& entry : fs::directory_iterator(directory))
+        totalSize += entry.file_size();
+    CHECK(totalSize <= fileSize * 3);
+    CacheKey newestKey = key;
+    newestKey.levelId += "5";
+    CHECK(smallCache.Load(newestKey, inputHash));
+
+    fs::remove_all(directory);
+
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// the vectorized kernels must give exactly the same results as the scalar ones
+
+#include "core/kernels.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace Generator;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+static uint32_t state = 360;
+static int Random(int max) {
+    state = state * 1664525 + 1013904223;
+    return (int) ((state >> 8) % max);
+}
+
+// ticks close to the tolerance around a reference, with some exact repeats and far away ones
+static int RandomTick(int reference, int tolerance) {
+    switch (Random(5)) {
+        case 0: return reference;
+        case 1: return reference + Random(2 * tolerance + 5) - tolerance - 2;
+        case 2: return reference + (Random(2) ? tolerance : -tolerance);
+        case 3: return reference + (Random(2) ? tolerance + 1 : -tolerance - 1);
+        default: return reference + Random(20000) - 10000;
+    }
+}
+
+static bool Equal(Kernels::DirectionCounts a, Kernels::DirectionCounts b) {
+    return a.left == b.left && a.right == b.right && a.count == b.count;
+}
+
+int main() {
+    printf("kernels: %s\n", Kernels::Implementation);
+
+#if defined(__AVX2__)
+    // this build uses avx2 instructions unconditionally
+    if (!__builtin_cpu_supports("avx2")) {
+        printf("avx2 not supported, skipping\n");
+        return 77;
+    }
+#endif
+
+    for (int round = 0; round < 20000; round++) {
+        int count = Random(100);
+        int reference = Random(1 << 20);
+        int tolerance = Random(8);
+
+        std::vector<int> ticks(count);
+        std::vector<uint8_t> directions(count);
+        std::vector<int> lines(count);
+        for (int i = 0; i < count; i++) {
+            ticks[i] = RandomTick(reference, tolerance);
+            // mostly real cut directions, sometimes out of range values
+            directions[i] = Random(20) == 0 ? Random(256) : Random(10);
+            lines[i] = Random(8) - 2;
+        }
+        // the same time check rarely passes with random ticks, so sometimes all are near with maybe one just outside
+        if (round % 4 == 0) {
+            for (auto& tick : ticks)
+                tick = reference + Random(2 * tolerance + 1) - tolerance;
+            if (count > 0 && Random(2) == 0)
+                ticks[Random(count)] = reference + (Random(2) ? tolerance + 1 : -tolerance - 1);
+        }
+
+        CHECK(Equal(Kernels::CountDirections(directions.data(), count), Kernels::Scalar::CountDirections(directions.data(), count)));
+        CHECK(Equal(Kernels::CountDirectionsNear(ticks.data(), directions.data(), count, reference, tolerance),
+            Kernels::Scalar::CountDirectionsNear(ticks.data(), directions.data(), count, reference, tolerance)));
+        CHECK(Kernels::AllNear(ticks.data(), count, reference, tolerance) == Kernels::Scalar::AllNear(ticks.data(), count, reference, tolerance));
+        CHECK(Kernels::CountBelow(ticks.data(), count, reference) == Kernels::Scalar::CountBelow(ticks.data(), count, reference));
+        CHECK(Kernels::LaneMask(lines.data(), count) == Kernels::Scalar::LaneMask(lines.data(), count));
+
+        if (failures > 10)
+            break;
+    }
+
+    // the scalar versions against the original loops
+    uint8_t directions[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    auto counts = Kernels::CountDirections(directions, 10);
+    CHECK(counts.left == 3 && counts.right == 3 && counts.count == 10);
+    int lines[] = {0, 2, 5, -1, 2};
+    CHECK(Kernels::LaneMask(lines, 5) == 0b101);
+    int ticks[] = {-3, 0, 0, 2, 5, 5, 9, 12, 12, 12};
+    CHECK(Kernels::CountBelow(ticks, 10, 5) == 4 && Kernels::CountBelow(ticks, 10, 13) == 10);
+    counts = Kernels::CountDirectionsNear(ticks, directions, 10, 3, 2);
+    CHECK(counts.left == 1 && counts.right == 2 && counts.count == 3);
+    CHECK(Kernels::AllNear(ticks + 7, 3, 12, 0) && !Kernels::AllNear(ticks + 6, 4, 12, 2) && Kernels::AllNear(ticks + 6, 4, 12, 3));
+
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+// generating in steps with a session must give the same edits as generating all at once
+// and generating variants from one analysis the same as generating each of them, with or without a pool
+// with a pool, chunks of bars are decided in parallel and joined, which must not change the result either
+// streamed like a level plays, every edit must be out before the object it touches spawns
+
+#include "core/generator.hpp"
+#include "core/threadpool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+using namespace Generator;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+static uint32_t state = 90;
+static int Random(int max) {
+    state = state * 1664525 + 1013904223;
+    return (int) ((state >> 8) % max);
+}
+
+// random map with bursts of notes at the same time, long walls and bombs
+static void CreateMap(float bpm, std::vector<Note>& notes, std::vector<Wall>& walls, int beats = 200) {
+    float beatDuration = 60 / bpm;
+    for (int beat = 0; beat < beats; beat++) {
+        for (int sub = 0; sub < 4; sub++) {
+            if (Random(3) == 0)
+                continue;
+            float time = (beat + sub * 0.25f) * beatDuration;
+            int notesAtTime = 1 + Random(3);
+            for (int n = 0; n < notesAtTime; n++) {
+                bool bomb = Random(8) == 0;
+                notes.push_back({
+                    time,
+                    Random(4),
+                    (LineLayer) Random(3),
+                    bomb ? ColorType::None : (ColorType) Random(2),
+                    bomb ? CutDirection::None : (CutDirection) Random(9)
+                });
+            }
+        }
+        if (Random(4) == 0)
+            walls.push_back({beat * beatDuration, beatDuration * Random(12) * 0.5f, Random(4), LineLayer::Base, 1 + Random(2), 5});
+    }
+}
+
+template<class T, class Compare>
+static void Sort(std::vector<T>& list, Compare compare) {
+    std::stable_sort(list.begin(), list.end(), compare);
+}
+
+static bool Equal(Result a, Result b) {
+    // the sessions give the edits in the order they become final, which can differ for walls
+    auto byTime = [](Wall const& a, Wall const& b) {
+        return std::tuple(a.time, a.lineIndex, a.duration, (int) a.lineLayer, a.width, a.height) < std::tuple(b.time, b.lineIndex, b.duration, (int) b.lineLayer, b.width, b.height);
+    };
+    Sort(a.splitWalls, byTime);
+    Sort(b.splitWalls, byTime);
+    Sort(a.generatedWalls, byTime);
+    Sort(b.generatedWalls, byTime);
+
+    if (a.rotations.size() != b.rotations.size() || a.removedNotes != b.removedNotes || a.mirroredNotes != b.mirroredNotes || a.removedWalls != b.removedWalls)
+        return false;
+    for (int i = 0; i < a.rotations.size(); i++) {
+        if (a.rotations[i].time != b.rotations[i].time || a.rotations[i].amount != b.rotations[i].amount || a.rotations[i].early != b.rotations[i].early)
+            return false;
+    }
+    if (a.changedWalls.size() != b.changedWalls.size())
+        return false;
+    for (int i = 0; i < a.changedWalls.size(); i++) {
+        if (a.changedWalls[i].index != b.changedWalls[i].index || a.changedWalls[i].time != b.changedWalls[i].time || a.changedWalls[i].duration != b.changedWalls[i].duration)
+            return false;
+    }
+    auto WallsEqual = [](std::vector<Wall> const& a, std::vector<Wall> const& b) {
+        if (a.size() != b.size())
+            return false;
+        for (int i = 0; i < a.size(); i++) {
+            if (a[i].time != b[i].time || a[i].duration != b[i].duration || a[i].lineIndex != b[i].lineIndex || a[i].lineLayer != b[i].lineLayer || a[i].width != b[i].width || a[i].height != b[i].height)
+                return false;
+        }
+        return true;
+    };
+    return WallsEqual(a.splitWalls, b.splitWalls) && WallsEqual(a.generatedWalls, b.generatedWalls);
+}
+
+// adds the edits of a step to the combined result
+static void Append(Result& combined, Result const& step) {
+    auto AppendList = [](auto& to, auto const& from) { to.insert(to.end(), from.begin(), from.end()); };
+    AppendList(combined.rotations, step.rotations);
+    AppendList(combined.removedNotes, step.removedNotes);
+    AppendList(combined.mirroredNotes, step.mirroredNotes);
+    AppendList(combined.removedWalls, step.removedWalls);
+    AppendList(combined.changedWalls, step.changedWalls);
+    AppendList(combined.generatedWalls, step.generatedWalls);
+    AppendList(combined.splitWalls, step.splitWalls);
+}
+
+// the earliest time of the objects the edits touch, the original time for the edited walls
+static float FirstEditedTime(Result const& edits, std::vector<Note> const& notes, std::vector<Wall> const& walls) {
+    float time = INFINITY;
+    for (auto& rotation : edits.rotations)
+        time = std::min(time, rotation.time);
+    for (int index : edits.removedNotes)
+        time = std::min(time, notes[index].time);
+    for (int index : edits.mirroredNotes)
+        time = std::min(time, notes[index].time);
+    for (int index : edits.removedWalls)
+        time = std::min(time, walls[index].time);
+    for (auto& change : edits.changedWalls)
+        time = std::min(time, walls[change.index].time);
+    for (auto& wall : edits.generatedWalls)
+        time = std::min(time, wall.time);
+    for (auto& wall : edits.splitWalls)
+        time = std::min(time, wall.time);
+    return time;
+}
+
+int main() {
+    ThreadPool pool(4);
+    for (int round = 0; round < 40; round++) {
+        float bpm = 80 + Random(200);
+        std::vector<Note> notes{};
+        std::vector<Wall> walls{};
+        CreateMap(bpm, notes, walls);
+
+        Params params{};
+        params.bpm = bpm;
+        params.enableSpin = Random(2);
+        params.spinCooldown = Random(4);
+        params.totalSpinTime = 0.1f + Random(30) * 0.1f;
+        params.wallGenerator = Random(2);
+        params.onlyOneSaber = Random(2);
+        params.leftHanded = Random(2);
+        params.wallBackCut = Random(10) * 0.1f;
+        params.wallFrontCut = Random(10) * 0.1f;
+        params.minWallDuration = Random(3) * 0.1f;
+
+        auto expected = Generate(notes, walls, params);
+
+        // steps of different sizes, and single bars with a deadline that has already passed
+        float stepSize = Random(5) * 0.5f;
+        bool singleBars = stepSize == 0;
+
+        Session session(notes, walls, params);
+        Result combined{};
+        float time = 0;
+        float previousCompleted = -INFINITY;
+        int steps = 0;
+        bool done = false;
+        while (!done && steps < 100000) {
+            time += stepSize;
+            if (singleBars)
+                done = session.Advance(INFINITY, std::chrono::steady_clock::time_point::min());
+            else
+                done = session.Advance(time);
+            Append(combined, session.TakeCompleted());
+
+            float completed = session.GetCompletedTime();
+            CHECK(completed >= previousCompleted);
+            previousCompleted = completed;
+            steps++;
+        }
+        CHECK(done);
+        CHECK(session.IsDone());
+        CHECK(std::isinf(session.GetCompletedTime()));
+
+        std::sort(combined.removedNotes.begin(), combined.removedNotes.end());
+        std::sort(combined.removedWalls.begin(), combined.removedWalls.end());
+        std::sort(combined.changedWalls.begin(), combined.changedWalls.end(), [](auto& a, auto& b) { return a.index < b.index; });
+        CHECK(Equal(combined, expected));
+        CHECK(Equal(session.TakeResult(), expected));
+
+        // the 90 degree variant from the same analysis
+        Params variants[2] = {params, params};
+        variants[1].rotationLimit = 2;
+        variants[1].bottleneckRotations = 1;
+        auto results = GenerateVariants(notes, walls, variants);
+        CHECK(results.size() == 2);
+        if (results.size() == 2) {
+            CHECK(Equal(results[0], expected));
+            CHECK(Equal(results[1], Generate(notes, walls, variants[1])));
+        }
+
+        // bars analyzed in parallel
+        CHECK(Equal(Generate(notes, walls, params, nullptr, &pool), expected));
+        results = GenerateVariants(notes, walls, variants, nullptr, &pool);
+        CHECK(results.size() == 2 && Equal(results[1], Generate(notes, walls, variants[1])));
+
+        if (failures > 0) {
+            printf("failed in round %d (step %.1f)\n", round, stepSize);
+            break;
+        }
+    }
+
+    // long maps with many chunks, with the 360 and 90 degree limits and any amount of threads
+    ThreadPool singleThread(1);
+    for (int round = 0; round < 12 && failures == 0; round++) {
+        float bpm = 80 + Random(200);
+        std::vector<Note> notes{};
+        std::vector<Wall> walls{};
+        CreateMap(bpm, notes, walls, 1000 + Random(2000));
+
+        Params params{};
+        params.bpm = bpm;
+        params.enableSpin = Random(2);
+        params.spinCooldown = Random(20);
+        params.wallGenerator = Random(2);
+        params.onlyOneSaber = Random(2);
+        if (round % 2) {
+            params.rotationLimit = 2;
+            params.bottleneckRotations = 1;
+        }
+
+        auto expected = Generate(notes, walls, params);
+        CHECK(Equal(Generate(notes, walls, params, nullptr, &pool), expected));
+        CHECK(Equal(Generate(notes, walls, params, nullptr, &singleThread), expected));
+    }
+
+    // a bar each frame like a stream that is always out of time, with walls much longer than the horizon
+    for (int round = 0; round < 40 && failures == 0; round++) {
+        float bpm = 80 + Random(200);
+        std::vector<Note> notes{};
+        std::vector<Wall> walls{};
+        CreateMap(bpm, notes, walls);
+        for (auto& wall : walls) {
+            if (Random(4) == 0)
+                wall.duration += 5 + Random(40);
+        }
+
+        Params params{};
+        params.bpm = bpm;
+        params.enableSpin = Random(2);
+        params.wallGenerator = Random(2);
+        params.onlyOneSaber = Random(2);
+        params.wallBackCut = Random(10) * 0.1f;
+        params.wallFrontCut = Random(10) * 0.1f;
+
+        float horizon = 0.5f + Random(10) * 0.5f;
+        float spawnAheadTime = 0.5f + Random(30) * 0.1f;
+        float frameTime = 0.01f + Random(10) * 0.01f;
+
+        Session session(notes, walls, params);
+        session.Advance(notes.front().time + horizon);
+        session.Finalize(spawnAheadTime + frameTime);
+        Result combined{};
+        Append(combined, session.TakeCompleted());
+
+        float songTime = 0;
+        int frames = 0;
+        while (!session.IsDone() && frames++ < 100000) {
+            songTime += frameTime;
+            session.Advance(songTime + horizon, std::chrono::steady_clock::time_point::min());
+            // what the next frame spawns has to be ready now
+            session.Finalize(songTime + frameTime + spawnAheadTime);
+            auto edits = session.TakeCompleted();
+            CHECK(FirstEditedTime(edits, notes, walls) - spawnAheadTime > songTime);
+            CHECK(session.GetCompletedTime() > songTime + frameTime + spawnAheadTime);
+            Append(combined, edits);
+            if (failures > 0)
+                break;
+        }
+        CHECK(session.IsDone());
+
+        std::sort(combined.removedNotes.begin(), combined.removedNotes.end());
+        std::sort(combined.removedWalls.begin(), combined.removedWalls.end());
+        std::sort(combined.changedWalls.begin(), combined.changedWalls.end(), [](auto& a, auto& b) { return a.index < b.index; });
+        CHECK(Equal(combined, Generate(notes, walls, params)));
+
+        if (failures > 0)
+            printf("failed streaming in round %d (horizon %.1f, spawn ahead %.1f)\n", round, horizon, spawnAheadTime);
+    }
+
+    // no notes
+    Session empty({}, {}, Params{});
+    CHECK(empty.IsDone());
+    CHECK(empty.Advance(INFINITY));
+    CHECK(GenerateVariants({}, {}, std::vector<Params>(2)).size() == 2);
+    CHECK(GenerateVariants({}, {}, std::vector<Params>(2), nullptr, &pool).size() == 2);
+
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// every job submitted to the pool must run exactly once, including jobs submitted by other jobs
+// and every index of a parallel loop exactly once, also when the loop is run from inside a job
+
+#include "core/threadpool.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+using namespace Generator;
+
+static int failures = 0;
+
+#define CHECK(condition) if (!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; }
+
+int main() {
+    for (int threads : {1, 2, 4, 8}) {
+        std::vector<std::atomic<int>> runs(1000);
+        ThreadPool pool(threads);
+        CHECK(pool.GetThreadCount() == threads);
+
+        // a few jobs that each submit many small ones, so the other workers have to steal them
+        for (int outer = 0; outer < 10; outer++) {
+            pool.Submit([&pool, &runs, outer]() {
+                for (int inner = 0; inner < 100; inner++)
+                    pool.Submit([&runs, index = outer * 100 + inner]() { runs[index]++; });
+            });
+        }
+        pool.Wait();
+
+        for (auto& count : runs)
+            CHECK(count == 1);
+
+        // the pool can be used again after waiting
+        std::atomic<int> total = 0;
+        for (int i = 0; i < 100; i++)
+            pool.Submit([&total]() { total++; });
+        pool.Wait();
+        CHECK(total == 100);
+
+        // loops from outside and from jobs, with more jobs running than workers
+        std::vector<std::atomic<int>> indices(5000);
+        pool.ParallelFor(1000, [&indices](int i) { indices[i]++; });
+        for (int outer = 1; outer < 5; outer++) {
+            pool.Submit([&pool, &indices, outer]() {
+                pool.ParallelFor(1000, [&indices, outer](int i) { indices[outer * 1000 + i]++; });
+            });
+        }
+        pool.Wait();
+        for (auto& count : indices)
+            CHECK(count == 1);
+        pool.ParallelFor(0, [](int) { failures++; });
+    }
+
+    // the destructor finishes the jobs that are left
+    std::atomic<int> total = 0;
+    {
+        ThreadPool pool(3);
+        for (int i = 0; i < 100; i++)
+            pool.Submit([&total]() { total++; });
+    }
+    CHECK(total == 100);
+
+    if (failures == 0)
+        printf("all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
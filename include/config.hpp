@@ -20,6 +20,16 @@ DECLARE_CONFIG(Config,
     CONFIG_VALUE(MinWallDuration, float, "Min Wall Duration", 0.1, "The minimum duration of a wall for it to be included")
     CONFIG_VALUE(WallGenerator, bool, "Generate Walls", false, "Generates extra walls, walls are cool in 360 mode")
     CONFIG_VALUE(OnlyOneSaber, bool, "One Saber", false, "Only keeps notes of one color")
+
+    CONFIG_VALUE(StreamingHorizon, float, "Streaming Horizon", 0, "Seconds generated before the level starts, the rest is generated while playing, 0 to generate everything before")
+    CONFIG_VALUE(Pregenerate, bool, "Pregenerate", true, "Generates levels in the background as soon as they are selected")
+    CONFIG_VALUE(PregenerateSet, bool, "Pregenerate Whole Set", false, "Also generates the other difficulties of a generated set in the background when a level is shown")
+    CONFIG_VALUE(PregenerateThreads, int, "Pregeneration Threads", 2, "The amount of difficulties generated at the same time")
+    CONFIG_VALUE(PregenerateMemory, int, "Pregeneration Memory (MB)", 32, "Memory for pregenerated levels that were not started yet, other difficulties of a set are skipped above it")
+    CONFIG_VALUE(CacheSize, int, "Cache Size (MB)", 16, "Memory used to keep generated levels for restarts, 0 to disable")
+    CONFIG_VALUE(DiskCacheSize, int, "Disk Cache Size (MB)", 64, "Storage used to keep generated levels between game launches, 0 to disable")
+
+    CONFIG_VALUE(TraceLevel, int, "Trace Level", 1, "Detail of the generator trace, 0 for none, 1 to log a summary, 2 and 3 to also record bars and segments for dumping")
 )
 
 #include "UnityEngine/GameObject.hpp"
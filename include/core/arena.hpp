@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Generator {
+    // monotonic memory for the scratch data of one generation, freed as a whole
+    // the first block is sized up front from the item counts, more blocks are only added if that was too small
+    class Arena {
+        struct Block {
+            std::unique_ptr<std::byte[]> memory;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        // in the last block
+        size_t offset = 0;
+        size_t usedBytes = 0;
+        size_t capacity = 0;
+
+        void AddBlock(size_t minimumSize);
+
+        public:
+        Arena(size_t initialSize);
+        Arena(Arena const&) = delete;
+        Arena& operator=(Arena const&) = delete;
+
+        void* Allocate(size_t size, size_t alignment);
+        // everything allocated before is invalid, the largest block is kept for reuse
+        void Reset();
+
+        // bytes handed out, and the size of all blocks
+        size_t GetUsedBytes() const { return usedBytes; }
+        size_t GetCapacity() const { return capacity; }
+        int GetBlockCount() const { return blocks.size(); }
+    };
+
+    // lets standard containers use an arena, freeing does nothing until the arena is reset
+    template<class T>
+    struct ArenaAllocator {
+        using value_type = T;
+
+        Arena* arena;
+
+        ArenaAllocator(Arena& arena) : arena(&arena) {}
+        template<class U>
+        ArenaAllocator(ArenaAllocator<U> const& other) : arena(other.arena) {}
+
+        T* allocate(size_t count) { return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) {}
+
+        template<class U>
+        bool operator==(ArenaAllocator<U> const& other) const { return arena == other.arena; }
+    };
+
+    template<class T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
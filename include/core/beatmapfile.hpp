@@ -0,0 +1,52 @@
+#pragma once
+
+#include "core/generator.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Generator {
+    struct BpmChange {
+        float beat;
+        float bpm;
+    };
+
+    // converts between beats and seconds through the bpm changes of a difficulty, the same as the game does
+    // the bpm of the Info.dat is used until the first change, a change at beat 0 replaces it
+    class Tempo {
+        struct Segment {
+            double beat;
+            double seconds;
+            double secondsPerBeat;
+        };
+
+        std::vector<Segment> segments;
+
+        public:
+        Tempo(float bpm, std::vector<BpmChange> changes = {});
+
+        double ToSeconds(double beat) const;
+        double ToBeats(double seconds) const;
+        bool IsConstant() const { return segments.size() == 1; }
+    };
+
+    // the parts of a difficulty file the generator uses, in v2 (_notes, _obstacles) or v3 (colorNotes, bombNotes, obstacles) format
+    // times are in beats, the items are in file order with the v3 bombs after the notes
+    struct BeatmapFile {
+        bool v3 = false;
+        std::vector<Note> notes;
+        std::vector<Wall> walls;
+        // v3 bpmEvents or v2 events of type 100, in file order
+        std::vector<BpmChange> bpmChanges;
+    };
+
+    // reads the mapped file in one pass without building a json document, everything the generator doesn't use is skipped
+    // nullopt if the file can't be read, is not a json object or has an unsupported version
+    std::optional<BeatmapFile> ReadBeatmapFile(std::string const& path);
+    std::optional<BeatmapFile> ParseBeatmapFile(std::string_view text);
+
+    // converts the times to seconds through the bpm changes and sorts the items by time like the game does, as needed by Generate
+    void ConvertToSeconds(BeatmapFile& file, float bpm);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core/generator.hpp"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace Generator {
+    struct CacheKey {
+        std::string levelId;
+        int difficulty;
+        std::string basedOn;
+        bool is90Degree;
+        bool leftHanded;
+        uint64_t settingsHash;
+
+        bool operator==(CacheKey const&) const = default;
+    };
+
+    struct CacheKeyHash {
+        size_t operator()(CacheKey const& key) const;
+    };
+
+    // approximate memory used by a result
+    size_t ResultSize(Result const& result);
+
+    // least recently used generation results, limited by their memory use
+    class ResultCache {
+        struct Entry {
+            CacheKey key;
+            uint64_t inputHash;
+            Result result;
+            size_t size;
+        };
+
+        // most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<CacheKey, std::list<Entry>::iterator, CacheKeyHash> lookup;
+        size_t maxBytes;
+        size_t usedBytes = 0;
+        int hits = 0;
+        int misses = 0;
+
+        void Evict();
+
+        public:
+        ResultCache(size_t maxBytes) : maxBytes(maxBytes) {}
+
+        void SetMaxBytes(size_t bytes);
+
+        // the input hash must also match, in case the beatmap was transformed differently
+        Result const* Find(CacheKey const& key, uint64_t inputHash);
+        bool Contains(CacheKey const& key) const { return lookup.contains(key); }
+        Result const& Insert(CacheKey const& key, uint64_t inputHash, Result result);
+        void Clear();
+
+        int GetHits() const { return hits; }
+        int GetMisses() const { return misses; }
+        size_t GetUsedBytes() const { return usedBytes; }
+        size_t GetCount() const { return entries.size(); }
+    };
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/cache.hpp"
+
+#include <optional>
+#include <string>
+
+namespace Generator {
+    // increase whenever the file layout, any of the result structs or the generated results change
+    constexpr uint32_t DiskCacheVersion = 4;
+
+    // generation results stored as one file per level, difficulty and settings
+    // files are the header followed by the raw result arrays, loaded with a single mmap
+    class DiskCache {
+        std::string directory;
+        size_t maxBytes;
+
+        public:
+        DiskCache(std::string directory, size_t maxBytes) : directory(std::move(directory)), maxBytes(maxBytes) {}
+
+        void SetMaxBytes(size_t bytes) { maxBytes = bytes; }
+        std::string const& GetDirectory() const { return directory; }
+
+        std::string GetPath(CacheKey const& key) const;
+
+        // files that don't match the key, version or input, or are corrupted, are deleted and nullopt is returned
+        std::optional<Result> Load(CacheKey const& key, uint64_t inputHash) const;
+        bool Save(CacheKey const& key, uint64_t inputHash, Result const& result) const;
+
+        // deletes the least recently used files until the total size is within the limit, and temporary files left from a crash
+        void Evict() const;
+    };
+}
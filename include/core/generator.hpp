@@ -0,0 +1,149 @@
+#pragma once
+
+// game independent version of the generator, works on plain structs so it can be built and profiled off the headset
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Generator {
+    // values match GlobalNamespace::NoteCutDirection
+    enum class CutDirection : uint8_t {
+        Up = 0,
+        Down = 1,
+        Left = 2,
+        Right = 3,
+        UpLeft = 4,
+        UpRight = 5,
+        DownLeft = 6,
+        DownRight = 7,
+        Any = 8,
+        None = 9,
+    };
+
+    // values match GlobalNamespace::ColorType
+    enum class ColorType : int8_t {
+        None = -1,
+        ColorA = 0,
+        ColorB = 1,
+    };
+
+    // values match GlobalNamespace::NoteLineLayer
+    enum class LineLayer : uint8_t {
+        Base = 0,
+        Upper = 1,
+        Top = 2,
+    };
+
+    struct Note {
+        float time;
+        int lineIndex;
+        LineLayer lineLayer;
+        ColorType colorType;
+        CutDirection cutDirection;
+    };
+
+    struct Wall {
+        float time;
+        float duration;
+        int lineIndex;
+        LineLayer lineLayer;
+        int width;
+        int height;
+    };
+
+    // every setting used by the generator, read once before a run
+    // defaults match the ones in config.hpp (360 degree limits)
+    struct Params {
+        float bpm = 120;
+        bool leftHanded = false;
+        int numberOfLines = 4;
+
+        float preferredBarDuration = 1.84;
+        int rotationLimit = 28;
+        int bottleneckRotations = 14;
+        bool enableSpin = false;
+        float totalSpinTime = 0.6;
+        float spinCooldown = 10;
+        float wallFrontCut = 0.2;
+        float wallBackCut = 0.45;
+        float minWallDuration = 0.1;
+        bool wallGenerator = false;
+        bool onlyOneSaber = false;
+    };
+
+    struct Rotation {
+        float time;
+        // in steps of 15 degrees
+        int amount;
+        // false is late
+        bool early;
+    };
+
+    struct WallChange {
+        int index;
+        float time;
+        float duration;
+    };
+
+    // edits to apply to the beatmap, indices refer to the spans passed to Generate
+    struct Result {
+        std::vector<Rotation> rotations;
+        std::vector<int> removedNotes;
+        std::vector<int> mirroredNotes;
+        std::vector<int> removedWalls;
+        std::vector<WallChange> changedWalls;
+        // walls added by the wall generator
+        std::vector<Wall> generatedWalls;
+        // second parts of walls that were cut in two
+        std::vector<Wall> splitWalls;
+    };
+
+    struct Stats;
+    class ThreadPool;
+
+    // notes (including bombs) and walls must be sorted by time
+    // the times and counts of each phase are added to stats if given
+    // with a pool, the notes of all bars are analyzed on it first and chunks of bars are decided on it, using more memory
+    // the result is the same as without one, whatever the amount of threads
+    Result Generate(std::span<Note const> notes, std::span<Wall const> walls, Params const& params, Stats* stats = nullptr, ThreadPool* pool = nullptr);
+
+    // the same results as Generate for each of the params, which can only differ in rotationLimit and bottleneckRotations
+    // the notes are analyzed once and only the rotations are decided for each, so the 90 and 360 degree results cost little more than one
+    // stats must have an entry for each variant if given, the analysis is added to the bar time of the first
+    std::vector<Result> GenerateVariants(std::span<Note const> notes, std::span<Wall const> walls, std::span<Params const> variants, Stats* stats = nullptr, ThreadPool* pool = nullptr);
+
+    struct SessionState;
+
+    // generation that can stop between bars and continue later, to have the start of a map ready before the rest
+    // all the edits from TakeCompleted together are the same as the result of Generate
+    class Session {
+        std::unique_ptr<SessionState> state;
+
+        public:
+        // the notes and walls are copied, the same requirements as Generate apply
+        Session(std::span<Note const> notes, std::span<Wall const> walls, Params const& params, Stats* stats = nullptr);
+        ~Session();
+
+        // runs the bars starting at or before the time, stopping early once past the deadline after at least one bar
+        // returns true when everything is done
+        bool Advance(float time, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+        // runs bars without a deadline until the edits of all objects at or before the time are final
+        // a long wall is only final once the bars past its end are decided, which can be far beyond the time
+        bool Finalize(float time);
+        bool IsDone() const;
+        // edits of objects before this time will not change anymore
+        float GetCompletedTime() const;
+
+        // edits that became final since the last call
+        Result TakeCompleted();
+        // the whole result once done, in the same order as from Generate
+        Result TakeResult();
+    };
+
+    // same as NoteData::Mirror and ObstacleData::Mirror for the fields the generator uses
+    void Mirror(Note& note, int numberOfLines);
+    void Mirror(Wall& wall, int numberOfLines);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "core/generator.hpp"
+
+namespace Generator {
+    // 64 bit FNV-1a, stable across runs and builds so it can be stored
+    class Hasher {
+        uint64_t value = 14695981039346656037ull;
+
+        public:
+        void AddBytes(void const* data, size_t size) {
+            auto bytes = (uint8_t const*) data;
+            for (size_t i = 0; i < size; i++) {
+                value ^= bytes[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        template<class T>
+        requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+        void Add(T t) {
+            AddBytes(&t, sizeof(T));
+        }
+
+        void Add(std::string_view string) {
+            Add(string.size());
+            AddBytes(string.data(), string.size());
+        }
+
+        uint64_t Get() const { return value; }
+    };
+
+    // identifies the input of a generation, field by field to skip padding
+    uint64_t HashInput(std::span<Note const> notes, std::span<Wall const> walls);
+
+    // identifies the edits of a generation, to check that results are identical
+    uint64_t HashResult(Result const& result);
+}
@@ -0,0 +1,394 @@
+#pragma once
+
+// data parallel helpers for the bar loop, working on packed arrays of the notes in a bar
+// times are integer ticks, so the vectorized versions only need integer compares
+// AVX2 or SSE2 on x86, NEON on arm, and a scalar version that the others must match exactly
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GENERATOR_KERNELS_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GENERATOR_KERNELS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define GENERATOR_KERNELS_NEON
+#endif
+
+namespace Generator::Kernels {
+    struct DirectionCounts {
+        int left = 0;
+        int right = 0;
+        // notes that were counted, left, right or neither
+        int count = 0;
+    };
+
+    // 1 for the directions pointing left, 2 for the ones pointing right, by CutDirection value
+    constexpr uint8_t DirectionSides[16] = {0, 0, 1, 2, 1, 2, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    namespace Scalar {
+        inline int Side(uint8_t direction) {
+            return direction < 16 ? DirectionSides[direction] : 0;
+        }
+
+        inline DirectionCounts CountDirections(uint8_t const* directions, int count) {
+            DirectionCounts counts{};
+            for (int i = 0; i < count; i++) {
+                int side = Side(directions[i]);
+                counts.left += side & 1;
+                counts.right += side >> 1;
+            }
+            counts.count = count;
+            return counts;
+        }
+
+        // only the notes with abs(ticks[i] - tick) <= tolerance
+        inline DirectionCounts CountDirectionsNear(int const* ticks, uint8_t const* directions, int count, int tick, int tolerance) {
+            DirectionCounts counts{};
+            for (int i = 0; i < count; i++) {
+                if (ticks[i] < tick - tolerance || ticks[i] > tick + tolerance)
+                    continue;
+                int side = Side(directions[i]);
+                counts.left += side & 1;
+                counts.right += side >> 1;
+                counts.count++;
+            }
+            return counts;
+        }
+
+        // false if any note has abs(ticks[i] - tick) > tolerance
+        inline bool AllNear(int const* ticks, int count, int tick, int tolerance) {
+            for (int i = 0; i < count; i++) {
+                if (ticks[i] < tick - tolerance || ticks[i] > tick + tolerance)
+                    return false;
+            }
+            return true;
+        }
+
+        // notes before the tick, which are the first ones if the ticks are sorted
+        inline int CountBelow(int const* ticks, int count, int tick) {
+            int below = 0;
+            for (int i = 0; i < count; i++)
+                below += ticks[i] < tick;
+            return below;
+        }
+
+        // bit n is set if any of the notes is on line n, for the first four lines
+        inline int LaneMask(int const* lines, int count) {
+            int mask = 0;
+            for (int i = 0; i < count; i++) {
+                if (lines[i] >= 0 && lines[i] < 4)
+                    mask |= 1 << lines[i];
+            }
+            return mask;
+        }
+    }
+
+#if defined(GENERATOR_KERNELS_AVX2)
+    constexpr char const* Implementation = "avx2";
+
+    namespace Simd {
+        // left and right bits for 32 directions
+        inline void SideMasks(uint8_t const* directions, uint32_t& left, uint32_t& right) {
+            auto table = _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i const*) DirectionSides));
+            auto values = _mm256_loadu_si256((__m256i const*) directions);
+            // indices above 15 would wrap around in the shuffle
+            auto sides = _mm256_shuffle_epi8(table, _mm256_min_epu8(values, _mm256_set1_epi8(15)));
+            left = _mm256_movemask_epi8(_mm256_cmpeq_epi8(sides, _mm256_set1_epi8(1)));
+            right = _mm256_movemask_epi8(_mm256_cmpeq_epi8(sides, _mm256_set1_epi8(2)));
+        }
+
+        // a bit for each of 8 ticks that is within low and high
+        inline uint32_t NearMask(int const* ticks, __m256i low, __m256i high) {
+            auto values = _mm256_loadu_si256((__m256i const*) ticks);
+            auto outside = _mm256_or_si256(_mm256_cmpgt_epi32(values, high), _mm256_cmpgt_epi32(low, values));
+            return ~_mm256_movemask_ps(_mm256_castsi256_ps(outside)) & 0xFF;
+        }
+
+        inline DirectionCounts CountDirections(uint8_t const* directions, int count) {
+            DirectionCounts counts{};
+            int i = 0;
+            for (; i + 32 <= count; i += 32) {
+                uint32_t left, right;
+                SideMasks(directions + i, left, right);
+                counts.left += std::popcount(left);
+                counts.right += std::popcount(right);
+            }
+            auto rest = Scalar::CountDirections(directions + i, count - i);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count = count;
+            return counts;
+        }
+
+        inline DirectionCounts CountDirectionsNear(int const* ticks, uint8_t const* directions, int count, int tick, int tolerance) {
+            DirectionCounts counts{};
+            auto low = _mm256_set1_epi32(tick - tolerance);
+            auto high = _mm256_set1_epi32(tick + tolerance);
+            int i = 0;
+            for (; i + 32 <= count; i += 32) {
+                uint32_t near = 0;
+                for (int j = 0; j < 4; j++)
+                    near |= NearMask(ticks + i + j * 8, low, high) << (j * 8);
+                uint32_t left, right;
+                SideMasks(directions + i, left, right);
+                counts.left += std::popcount(near & left);
+                counts.right += std::popcount(near & right);
+                counts.count += std::popcount(near);
+            }
+            auto rest = Scalar::CountDirectionsNear(ticks + i, directions + i, count - i, tick, tolerance);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count += rest.count;
+            return counts;
+        }
+
+        inline bool AllNear(int const* ticks, int count, int tick, int tolerance) {
+            auto low = _mm256_set1_epi32(tick - tolerance);
+            auto high = _mm256_set1_epi32(tick + tolerance);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                if (NearMask(ticks + i, low, high) != 0xFF)
+                    return false;
+            }
+            return Scalar::AllNear(ticks + i, count - i, tick, tolerance);
+        }
+
+        inline int CountBelow(int const* ticks, int count, int tick) {
+            auto tickVector = _mm256_set1_epi32(tick);
+            int below = 0;
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                auto less = _mm256_cmpgt_epi32(tickVector, _mm256_loadu_si256((__m256i const*) (ticks + i)));
+                below += std::popcount((uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(less)));
+            }
+            return below + Scalar::CountBelow(ticks + i, count - i, tick);
+        }
+
+        inline int LaneMask(int const* lines, int count) {
+            auto any = _mm256_setzero_si256();
+            auto lane0 = _mm256_set1_epi32(0);
+            auto lane1 = _mm256_set1_epi32(1);
+            auto lane2 = _mm256_set1_epi32(2);
+            auto lane3 = _mm256_set1_epi32(3);
+            // each 32 bit element of any collects the lanes seen in its position
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                auto values = _mm256_loadu_si256((__m256i const*) (lines + i));
+                any = _mm256_or_si256(any, _mm256_and_si256(_mm256_cmpeq_epi32(values, lane0), _mm256_set1_epi32(1)));
+                any = _mm256_or_si256(any, _mm256_and_si256(_mm256_cmpeq_epi32(values, lane1), _mm256_set1_epi32(2)));
+                any = _mm256_or_si256(any, _mm256_and_si256(_mm256_cmpeq_epi32(values, lane2), _mm256_set1_epi32(4)));
+                any = _mm256_or_si256(any, _mm256_and_si256(_mm256_cmpeq_epi32(values, lane3), _mm256_set1_epi32(8)));
+            }
+            alignas(32) int elements[8];
+            _mm256_store_si256((__m256i*) elements, any);
+            int mask = Scalar::LaneMask(lines + i, count - i);
+            for (int element : elements)
+                mask |= element;
+            return mask;
+        }
+    }
+#elif defined(GENERATOR_KERNELS_SSE2)
+    constexpr char const* Implementation = "sse2";
+
+    namespace Simd {
+        // left and right bits for 16 directions, without a byte shuffle the lookup is done with compares
+        inline void SideMasks(uint8_t const* directions, uint32_t& left, uint32_t& right) {
+            auto values = _mm_loadu_si128((__m128i const*) directions);
+            auto Is = [&values](char direction) { return _mm_cmpeq_epi8(values, _mm_set1_epi8(direction)); };
+            left = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(Is(2), Is(4)), Is(6)));
+            right = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(Is(3), Is(5)), Is(7)));
+        }
+
+        // a bit for each of 4 ticks that is within low and high
+        inline uint32_t NearMask(int const* ticks, __m128i low, __m128i high) {
+            auto values = _mm_loadu_si128((__m128i const*) ticks);
+            auto outside = _mm_or_si128(_mm_cmpgt_epi32(values, high), _mm_cmpgt_epi32(low, values));
+            return ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+        }
+
+        inline DirectionCounts CountDirections(uint8_t const* directions, int count) {
+            DirectionCounts counts{};
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                uint32_t left, right;
+                SideMasks(directions + i, left, right);
+                counts.left += std::popcount(left);
+                counts.right += std::popcount(right);
+            }
+            auto rest = Scalar::CountDirections(directions + i, count - i);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count = count;
+            return counts;
+        }
+
+        inline DirectionCounts CountDirectionsNear(int const* ticks, uint8_t const* directions, int count, int tick, int tolerance) {
+            DirectionCounts counts{};
+            auto low = _mm_set1_epi32(tick - tolerance);
+            auto high = _mm_set1_epi32(tick + tolerance);
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                uint32_t near = 0;
+                for (int j = 0; j < 4; j++)
+                    near |= NearMask(ticks + i + j * 4, low, high) << (j * 4);
+                uint32_t left, right;
+                SideMasks(directions + i, left, right);
+                counts.left += std::popcount(near & left);
+                counts.right += std::popcount(near & right);
+                counts.count += std::popcount(near);
+            }
+            auto rest = Scalar::CountDirectionsNear(ticks + i, directions + i, count - i, tick, tolerance);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count += rest.count;
+            return counts;
+        }
+
+        inline bool AllNear(int const* ticks, int count, int tick, int tolerance) {
+            auto low = _mm_set1_epi32(tick - tolerance);
+            auto high = _mm_set1_epi32(tick + tolerance);
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                if (NearMask(ticks + i, low, high) != 0xF)
+                    return false;
+            }
+            return Scalar::AllNear(ticks + i, count - i, tick, tolerance);
+        }
+
+        inline int CountBelow(int const* ticks, int count, int tick) {
+            auto tickVector = _mm_set1_epi32(tick);
+            int below = 0;
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                auto less = _mm_cmpgt_epi32(tickVector, _mm_loadu_si128((__m128i const*) (ticks + i)));
+                below += std::popcount((uint32_t) _mm_movemask_ps(_mm_castsi128_ps(less)));
+            }
+            return below + Scalar::CountBelow(ticks + i, count - i, tick);
+        }
+
+        inline int LaneMask(int const* lines, int count) {
+            auto any = _mm_setzero_si128();
+            // each 32 bit element of any collects the lanes seen in its position
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                auto values = _mm_loadu_si128((__m128i const*) (lines + i));
+                any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(values, _mm_set1_epi32(0)), _mm_set1_epi32(1)));
+                any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(values, _mm_set1_epi32(1)), _mm_set1_epi32(2)));
+                any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(values, _mm_set1_epi32(2)), _mm_set1_epi32(4)));
+                any = _mm_or_si128(any, _mm_and_si128(_mm_cmpeq_epi32(values, _mm_set1_epi32(3)), _mm_set1_epi32(8)));
+            }
+            alignas(16) int elements[4];
+            _mm_store_si128((__m128i*) elements, any);
+            int mask = Scalar::LaneMask(lines + i, count - i);
+            for (int element : elements)
+                mask |= element;
+            return mask;
+        }
+    }
+#elif defined(GENERATOR_KERNELS_NEON)
+    constexpr char const* Implementation = "neon";
+
+    namespace Simd {
+        // 1 and 2 in the bytes of 16 directions, indices above 15 give 0 in the table lookup
+        inline uint8x16_t Sides(uint8_t const* directions) {
+            return vqtbl1q_u8(vld1q_u8(DirectionSides), vld1q_u8(directions));
+        }
+
+        // all ones for each of 4 ticks that is within low and high
+        inline uint32x4_t NearMask(int const* ticks, int32x4_t low, int32x4_t high) {
+            auto values = vld1q_s32(ticks);
+            return vandq_u32(vcgeq_s32(values, low), vcleq_s32(values, high));
+        }
+
+        inline DirectionCounts CountDirections(uint8_t const* directions, int count) {
+            DirectionCounts counts{};
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                auto sides = Sides(directions + i);
+                counts.left += vaddvq_u8(vandq_u8(sides, vdupq_n_u8(1)));
+                counts.right += vaddvq_u8(vshrq_n_u8(sides, 1));
+            }
+            auto rest = Scalar::CountDirections(directions + i, count - i);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count = count;
+            return counts;
+        }
+
+        inline DirectionCounts CountDirectionsNear(int const* ticks, uint8_t const* directions, int count, int tick, int tolerance) {
+            DirectionCounts counts{};
+            auto low = vdupq_n_s32(tick - tolerance);
+            auto high = vdupq_n_s32(tick + tolerance);
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                // narrow the four 32 bit masks to one byte mask per note
+                auto near0 = vmovn_u32(NearMask(ticks + i, low, high));
+                auto near1 = vmovn_u32(NearMask(ticks + i + 4, low, high));
+                auto near2 = vmovn_u32(NearMask(ticks + i + 8, low, high));
+                auto near3 = vmovn_u32(NearMask(ticks + i + 12, low, high));
+                auto near = vcombine_u8(vmovn_u16(vcombine_u16(near0, near1)), vmovn_u16(vcombine_u16(near2, near3)));
+                auto sides = vandq_u8(Sides(directions + i), near);
+                counts.left += vaddvq_u8(vandq_u8(sides, vdupq_n_u8(1)));
+                counts.right += vaddvq_u8(vshrq_n_u8(sides, 1));
+                counts.count += vaddvq_u8(vandq_u8(near, vdupq_n_u8(1)));
+            }
+            auto rest = Scalar::CountDirectionsNear(ticks + i, directions + i, count - i, tick, tolerance);
+            counts.left += rest.left;
+            counts.right += rest.right;
+            counts.count += rest.count;
+            return counts;
+        }
+
+        inline bool AllNear(int const* ticks, int count, int tick, int tolerance) {
+            auto low = vdupq_n_s32(tick - tolerance);
+            auto high = vdupq_n_s32(tick + tolerance);
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                if (vminvq_u32(NearMask(ticks + i, low, high)) == 0)
+                    return false;
+            }
+            return Scalar::AllNear(ticks + i, count - i, tick, tolerance);
+        }
+
+        inline int CountBelow(int const* ticks, int count, int tick) {
+            auto tickVector = vdupq_n_s32(tick);
+            int below = 0;
+            int i = 0;
+            for (; i + 4 <= count; i += 4)
+                below += vaddvq_u32(vshrq_n_u32(vcltq_s32(vld1q_s32(ticks + i), tickVector), 31));
+            return below + Scalar::CountBelow(ticks + i, count - i, tick);
+        }
+
+        inline int LaneMask(int const* lines, int count) {
+            auto any = vdupq_n_u32(0);
+            // each 32 bit element of any collects the lanes seen in its position
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                auto values = vld1q_s32(lines + i);
+                any = vorrq_u32(any, vandq_u32(vceqq_s32(values, vdupq_n_s32(0)), vdupq_n_u32(1)));
+                any = vorrq_u32(any, vandq_u32(vceqq_s32(values, vdupq_n_s32(1)), vdupq_n_u32(2)));
+                any = vorrq_u32(any, vandq_u32(vceqq_s32(values, vdupq_n_s32(2)), vdupq_n_u32(4)));
+                any = vorrq_u32(any, vandq_u32(vceqq_s32(values, vdupq_n_s32(3)), vdupq_n_u32(8)));
+            }
+            auto pairs = vorr_u32(vget_low_u32(any), vget_high_u32(any));
+            int mask = vget_lane_u32(pairs, 0) | vget_lane_u32(pairs, 1);
+            return mask | Scalar::LaneMask(lines + i, count - i);
+        }
+    }
+#else
+    constexpr char const* Implementation = "scalar";
+
+    namespace Simd = Scalar;
+#endif
+
+    // the best implementation for the target
+    using Simd::CountDirections;
+    using Simd::CountDirectionsNear;
+    using Simd::AllNear;
+    using Simd::CountBelow;
+    using Simd::LaneMask;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+
+namespace Generator {
+    // milliseconds spent in each phase of a generation and the amount of objects involved
+    struct Stats {
+        // measured by the caller, around the work on the game's beatmap data
+        float copyTime = 0;
+        float extractTime = 0;
+        // the two passes over the game's item list when applying a result
+        float removeTime = 0;
+        float insertTime = 0;
+
+        // measured by Generate, the bar loop time includes the spin and wall generation times
+        // with a pool those two are summed over the threads deciding bars, so they can add up to more than the bar loop
+        float barTime = 0;
+        float spinTime = 0;
+        float wallGenerationTime = 0;
+        float wallCutTime = 0;
+        float bombTime = 0;
+
+        int notes = 0;
+        int walls = 0;
+        int cuts = 0;
+        int splitWalls = 0;
+        int removedNotes = 0;
+        int removedWalls = 0;
+        // bars decided again because a chunk decided in parallel started from a different carried state
+        int redecidedBars = 0;
+
+        // scratch memory of the generation
+        size_t arenaBytes = 0;
+        size_t arenaCapacity = 0;
+
+        float TotalTime() const { return copyTime + extractTime + barTime + wallCutTime + bombTime + removeTime + insertTime; }
+    };
+
+    // adds the time until it goes out of scope to a stats field, does nothing without one
+    class ScopedTimer {
+        float* target;
+        std::chrono::steady_clock::time_point start;
+
+        public:
+        ScopedTimer(float* target) : target(target) {
+            if (target)
+                start = std::chrono::steady_clock::now();
+        }
+        ~ScopedTimer() {
+            if (target)
+                *target += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    // all the times and counts on one line
+    std::string FormatStats(Stats const& stats);
+
+    // the stats of the most recent generations
+    class StatsHistory {
+        static constexpr int Size = 32;
+        std::array<Stats, Size> entries{};
+        int next = 0;
+        int count = 0;
+
+        public:
+        void Add(Stats const& stats);
+        int GetCount() const { return count; }
+        Stats Average() const;
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Generator {
+    // fixed set of workers that each have their own queue of jobs
+    // jobs submitted from a worker go to the front of its own queue, idle workers steal from the back of the others
+    class ThreadPool {
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        // jobs in the queues, and jobs submitted but not finished
+        size_t queued = 0;
+        size_t pending = 0;
+        size_t nextQueue = 0;
+        bool stopping = false;
+
+        bool TakeJob(int worker, std::function<void()>& job);
+        void Work(int worker);
+
+        public:
+        // 0 uses one worker per core
+        ThreadPool(int threads = 0);
+        // finishes every submitted job first
+        ~ThreadPool();
+
+        int GetThreadCount() const { return workers.size(); }
+
+        void Submit(std::function<void()> job);
+        // waits until every job is done, including the ones submitted by other jobs
+        void Wait();
+        // runs the body for each index on the workers and the calling thread, and returns once all are done
+        // the calling thread takes indices too instead of only waiting, so it can be called from a job without blocking the pool
+        void ParallelFor(int count, std::function<void(int)> body);
+    };
+}
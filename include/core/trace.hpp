@@ -0,0 +1,50 @@
+#pragma once
+
+// leveled tracing for the generator
+// messages above GENERATOR_TRACE_LEVEL are compiled out, ones above the runtime level are skipped before formatting
+// info messages go to the log function, every message is kept in a fixed size ring buffer that can be dumped on demand
+
+#include <atomic>
+
+// highest level compiled in, 0 removes all tracing
+#ifndef GENERATOR_TRACE_LEVEL
+#define GENERATOR_TRACE_LEVEL 3
+#endif
+
+namespace Generator {
+    enum class TraceLevel : int {
+        None = 0,
+        // once per generation
+        Info = 1,
+        // once per bar
+        Debug = 2,
+        // once per bar segment or wall cut
+        Verbose = 3,
+    };
+
+    // amount and maximum length of the messages kept in the ring buffer
+    constexpr int TraceBufferCount = 1024;
+    constexpr int TraceMessageSize = 160;
+
+    inline std::atomic<TraceLevel> currentTraceLevel = TraceLevel::Info;
+
+    inline void SetTraceLevel(TraceLevel level) { currentTraceLevel.store(level, std::memory_order_relaxed); }
+    inline bool TraceEnabled(TraceLevel level) { return level <= currentTraceLevel.load(std::memory_order_relaxed); }
+
+    // receives info messages and dumps, nothing is logged if unset
+    void SetLogFunction(void (*function)(char const* message));
+
+    __attribute__((format(printf, 2, 3)))
+    void Trace(TraceLevel level, char const* format, ...);
+
+    // sends the buffered messages to the log function, oldest first, and clears the buffer
+    void DumpTrace();
+    void ClearTrace();
+}
+
+#define GENERATOR_TRACE(level, ...) do { \
+    if constexpr ((int) ::Generator::TraceLevel::level <= GENERATOR_TRACE_LEVEL) { \
+        if (::Generator::TraceEnabled(::Generator::TraceLevel::level)) \
+            ::Generator::Trace(::Generator::TraceLevel::level, __VA_ARGS__); \
+    } \
+} while (0)
@@ -1,7 +1,56 @@
 #pragma once
 
 #include "GlobalNamespace/IReadonlyBeatmapData.hpp"
+#include "GlobalNamespace/BeatmapDataItem.hpp"
+#include "System/Collections/Generic/LinkedListNode_1.hpp"
+
+#include "core/generator.hpp"
+#include "core/cache.hpp"
+#include "core/diskcache.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GlobalNamespace {
+    class BeatmapData;
+    class NoteData;
+    class ObstacleData;
+}
 
 bool SettingsAreDefault(bool for90Degree);
 
-GlobalNamespace::IReadonlyBeatmapData* Generate(GlobalNamespace::IReadonlyBeatmapData* base, float bpm, bool is90Degree, bool leftHanded);
+uint64_t SettingsHash();
+
+Generator::Params GetParams(float bpm, bool is90Degree, bool leftHanded, int numberOfLines);
+
+Generator::ResultCache& GetResultCache();
+
+Generator::DiskCache& GetDiskCache();
+
+Generator::CacheKey GetCacheKey(std::string const& levelId, int difficulty, bool is90Degree, bool leftHanded);
+
+using ItemNode = System::Collections::Generic::LinkedListNode_1<GlobalNamespace::BeatmapDataItem*>;
+
+// where the notes and walls are in the list of all items, for edits applied a few at a time while the level plays
+struct ItemNodes {
+    std::vector<ItemNode*> notes;
+    std::vector<ItemNode*> walls;
+    // insertions start searching from the last inserted node instead of the start of the list
+    ItemNode* lastInserted = nullptr;
+};
+
+// finds the notes and walls for the generator, optionally with the objects they came from and their nodes
+void ExtractItems(GlobalNamespace::IReadonlyBeatmapData* data, std::vector<Generator::Note>& notes, std::vector<Generator::Wall>& walls,
+    std::vector<GlobalNamespace::NoteData*>* noteObjects, std::vector<GlobalNamespace::ObstacleData*>* wallObjects, ItemNodes* nodes);
+
+// edits the objects, which must be the ones the result was generated from, the edited ones must not be used by any other beatmap
+// the removal and insertion passes are timed into stats if there is one
+// with the nodes, removed objects are unlinked directly and only the part of the list around the insertions is walked
+void ApplyResult(GlobalNamespace::BeatmapData* data, Generator::Result const& result,
+    std::vector<GlobalNamespace::NoteData*> const& noteObjects, std::vector<GlobalNamespace::ObstacleData*> const& wallObjects, Generator::Stats* stats, ItemNodes* nodes);
+
+// transformed means base is a copy the transforms made for this level, not the level's own data
+// the spawn ahead time is how long before their time the level spawns objects, which a stream must have edited by then
+GlobalNamespace::IReadonlyBeatmapData* Generate(GlobalNamespace::IReadonlyBeatmapData* base, bool transformed, float bpm, bool is90Degree, bool leftHanded, std::string const& levelId, int difficulty,
+    float spawnAheadTime);
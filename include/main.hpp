@@ -5,3 +5,4 @@
 #include "beatsaber-hook/shared/utils/hooking.hpp"
 
 Logger& getLogger();
+ModInfo& getModInfo();
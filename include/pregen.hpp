@@ -0,0 +1,26 @@
+#pragma once
+
+#include "core/generator.hpp"
+#include "core/cache.hpp"
+#include "core/threadpool.hpp"
+
+#include "GlobalNamespace/IDifficultyBeatmap.hpp"
+#include "GlobalNamespace/IDifficultyBeatmapSet.hpp"
+#include "GlobalNamespace/BeatmapDifficulty.hpp"
+#include "GlobalNamespace/PlayerData.hpp"
+
+#include <optional>
+
+// starts generating the selected difficulty on a worker thread, if it isn't already
+void StartPregeneration(GlobalNamespace::IDifficultyBeatmap* difficultyBeatmap, GlobalNamespace::PlayerData* playerData, bool is90Degree);
+
+// starts generating every difficulty of a generated set, the shown one first
+// the others are skipped when the pregenerated results would use more than the configured memory
+void StartSetPregeneration(GlobalNamespace::IDifficultyBeatmapSet* set, GlobalNamespace::BeatmapDifficulty shownDifficulty, GlobalNamespace::PlayerData* playerData, bool is90Degree);
+
+// the workers of the pregenerations, also used to analyze the notes when generating at level load
+Generator::ThreadPool& GetPregenerationPool();
+
+// takes the result of a matching pregeneration, nullopt if there was none, it used different notes or it isn't done shortly
+// one that isn't done is dropped, the level is generated without it
+std::optional<Generator::Result> TakePregenerated(Generator::CacheKey const& key, uint64_t inputHash);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "generator.hpp"
+#include "core/generator.hpp"
+#include "core/cache.hpp"
+
+#include "GlobalNamespace/BeatmapData.hpp"
+#include "GlobalNamespace/NoteData.hpp"
+#include "GlobalNamespace/ObstacleData.hpp"
+
+#include <vector>
+
+// the move duration and half of the jump duration, like the game computes them for the level's note jump speed and offset
+float SpawnAheadTime(float bpm, float noteJumpSpeed, float noteJumpOffset);
+
+// generates the part of the level up to the horizon and applies it to the data right away
+// the rest is generated and applied while the level plays, keeping the horizon ahead of the song time
+// objects spawning within the spawn ahead time always have their edits, even if that takes longer than the frame budget
+void StartStreaming(GlobalNamespace::BeatmapData* data, std::span<Generator::Note const> notes, std::span<Generator::Wall const> walls, Generator::Params const& params,
+    std::vector<GlobalNamespace::NoteData*> noteObjects, std::vector<GlobalNamespace::ObstacleData*> wallObjects, ItemNodes nodes, Generator::CacheKey key, uint64_t inputHash,
+    float horizon, float spawnAheadTime);
+
+// called every frame of the level, does nothing if no level is being streamed
+void ContinueStreaming(float songTime);
+
+// drops the current stream if it was not finished
+void StopStreaming();
@@ -1,5 +1,6 @@
 #include "main.hpp"
 #include "config.hpp"
+#include "core/trace.hpp"
 
 #include "GlobalNamespace/MainSystemInit.hpp"
 #include "GlobalNamespace/BeatmapCharacteristicCollectionSO.hpp"
@@ -59,4 +60,16 @@ void GameplaySetup(UnityEngine::GameObject* self, bool firstActivation) {
     AddConfigValueIncrementFloat(container, getConfig().MinWallDuration, 2, 0.05, 0, 5);
     AddConfigValueToggle(container, getConfig().WallGenerator);
     AddConfigValueToggle(container, getConfig().OnlyOneSaber);
+    AddConfigValueIncrementFloat(container, getConfig().StreamingHorizon, 0, 5, 0, 60);
+    AddConfigValueToggle(container, getConfig().Pregenerate);
+    AddConfigValueToggle(container, getConfig().PregenerateSet);
+    AddConfigValueIncrementInt(container, getConfig().PregenerateThreads, 1, 1, 8);
+    AddConfigValueIncrementInt(container, getConfig().PregenerateMemory, 8, 8, 256);
+    AddConfigValueIncrementInt(container, getConfig().CacheSize, 4, 0, 256);
+    AddConfigValueIncrementInt(container, getConfig().DiskCacheSize, 16, 0, 1024);
+
+    AddConfigValueIncrementInt(container, getConfig().TraceLevel, 1, 0, 3);
+    BeatSaberUI::CreateUIButton(container, "Dump Trace", []() {
+        Generator::DumpTrace();
+    });
 }
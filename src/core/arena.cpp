@@ -0,0 +1,48 @@
+#include "core/arena.hpp"
+
+#include <algorithm>
+
+namespace Generator {
+    // blocks added after the first are at least this big, so a bad estimate doesn't cause many small blocks
+    static constexpr size_t MinimumBlockSize = 16 * 1024;
+
+    Arena::Arena(size_t initialSize) {
+        if (initialSize > 0)
+            AddBlock(initialSize);
+    }
+
+    void Arena::AddBlock(size_t minimumSize) {
+        // an eighth more at least, the first block is usually close so most of a bigger one would be unused
+        size_t size = std::max({minimumSize, capacity / 8, MinimumBlockSize});
+        blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(size), size});
+        capacity += size;
+        offset = 0;
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        if (blocks.empty())
+            AddBlock(size + alignment);
+
+        auto& block = blocks.back();
+        size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (start + size > block.size) {
+            AddBlock(size + alignment);
+            return Allocate(size, alignment);
+        }
+        offset = start + size;
+        usedBytes += size;
+        return block.memory.get() + start;
+    }
+
+    void Arena::Reset() {
+        if (blocks.size() > 1) {
+            auto largest = std::max_element(blocks.begin(), blocks.end(), [](auto& a, auto& b) { return a.size < b.size; });
+            auto kept = std::move(*largest);
+            blocks.clear();
+            blocks.push_back(std::move(kept));
+        }
+        capacity = blocks.empty() ? 0 : blocks[0].size;
+        offset = 0;
+        usedBytes = 0;
+    }
+}
@@ -0,0 +1,317 @@
+#include "core/beatmapfile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Generator {
+    enum class ListType {
+        V2Notes,
+        ColorNotes,
+        BombNotes,
+        V2Walls,
+        V3Walls,
+        V2Events,
+        BpmEvents,
+    };
+
+    // the fields read from each item of a list, in the order they are stored
+    struct ListFormat {
+        std::string_view name;
+        ListType type;
+        std::array<std::string_view, 6> fields;
+    };
+
+    static constexpr ListFormat Lists[] = {
+        {"_notes", ListType::V2Notes, {"_time", "_lineIndex", "_lineLayer", "_type", "_cutDirection"}},
+        {"colorNotes", ListType::ColorNotes, {"b", "x", "y", "c", "d"}},
+        {"bombNotes", ListType::BombNotes, {"b", "x", "y"}},
+        {"_obstacles", ListType::V2Walls, {"_time", "_lineIndex", "_type", "_duration", "_width"}},
+        {"obstacles", ListType::V3Walls, {"b", "x", "y", "d", "w", "h"}},
+        // only the bpm changes are kept from the events
+        {"_events", ListType::V2Events, {"_time", "_type", "_floatValue"}},
+        {"bpmEvents", ListType::BpmEvents, {"b", "m"}},
+    };
+
+    // reads json without storing it, the callers decide what to keep and skip the rest
+    struct Scanner {
+        char const* position;
+        char const* end;
+
+        void SkipWhitespace() {
+            while (position < end && (*position == ' ' || *position == '\n' || *position == '\r' || *position == '\t'))
+                position++;
+        }
+
+        bool Consume(char c) {
+            SkipWhitespace();
+            if (position == end || *position != c)
+                return false;
+            position++;
+            return true;
+        }
+
+        // the contents are left escaped, none of the keys that are looked for have escapes
+        bool ReadString(std::string_view& string) {
+            if (!Consume('"'))
+                return false;
+            auto start = position;
+            while (true) {
+                auto quote = (char const*) memchr(position, '"', end - position);
+                if (!quote)
+                    return false;
+                position = quote + 1;
+                // the quote is escaped if an odd number of backslashes is in front of it
+                int backslashes = 0;
+                while (quote - backslashes > start && quote[-backslashes - 1] == '\\')
+                    backslashes++;
+                if (backslashes % 2 == 0) {
+                    string = std::string_view(start, quote - start);
+                    return true;
+                }
+            }
+        }
+
+        bool ReadNumber(double& number) {
+            SkipWhitespace();
+            auto result = std::from_chars(position, end, number);
+            if (result.ec != std::errc())
+                return false;
+            position = result.ptr;
+            return true;
+        }
+
+        // only checks that brackets are balanced, not that the skipped value is valid json
+        bool SkipValue() {
+            SkipWhitespace();
+            if (position == end)
+                return false;
+            std::string_view string;
+            if (*position == '"')
+                return ReadString(string);
+            if (*position != '{' && *position != '[') {
+                // numbers, true, false and null
+                auto start = position;
+                while (position < end && !strchr(",]} \n\r\t", *position))
+                    position++;
+                return position > start;
+            }
+            int depth = 0;
+            while (position < end) {
+                switch (*position) {
+                    case '"':
+                        if (!ReadString(string))
+                            return false;
+                        continue;
+                    case '{':
+                    case '[':
+                        depth++;
+                        break;
+                    case '}':
+                    case ']':
+                        if (--depth == 0) {
+                            position++;
+                            return true;
+                        }
+                        break;
+                }
+                position++;
+            }
+            return false;
+        }
+
+        // calls the function with each key, which must read or skip the value
+        template<class F>
+        bool ForEachMember(F&& function) {
+            if (!Consume('{'))
+                return false;
+            if (Consume('}'))
+                return true;
+            do {
+                std::string_view key;
+                if (!ReadString(key) || !Consume(':') || !function(key))
+                    return false;
+            } while (Consume(','));
+            return Consume('}');
+        }
+
+        // calls the function for each element, which must read or skip it
+        template<class F>
+        bool ForEachElement(F&& function) {
+            if (!Consume('['))
+                return false;
+            if (Consume(']'))
+                return true;
+            do {
+                if (!function())
+                    return false;
+            } while (Consume(','));
+            return Consume(']');
+        }
+    };
+
+    static void AddItem(BeatmapFile& file, ListType type, std::array<double, 6> const& values) {
+        switch (type) {
+            case ListType::V2Notes:
+            case ListType::ColorNotes: {
+                int color = values[3];
+                // v2 bombs are notes of type 3, type 2 was never used
+                if (type == ListType::V2Notes && color == 3) {
+                    file.notes.push_back({(float) values[0], (int) values[1], (LineLayer) (int) values[2], ColorType::None, CutDirection::None});
+                    break;
+                }
+                if (color != 0 && color != 1)
+                    break;
+                file.notes.push_back({(float) values[0], (int) values[1], (LineLayer) (int) values[2], (ColorType) color, (CutDirection) (int) values[4]});
+                break;
+            }
+            case ListType::BombNotes:
+                file.notes.push_back({(float) values[0], (int) values[1], (LineLayer) (int) values[2], ColorType::None, CutDirection::None});
+                break;
+            case ListType::V2Walls: {
+                // the same as the game converts full height and crouch walls
+                bool top = values[2] == 1;
+                file.walls.push_back({(float) values[0], (float) values[3], (int) values[1], top ? LineLayer::Top : LineLayer::Base, (int) values[4], top ? 3 : 5});
+                break;
+            }
+            case ListType::V3Walls:
+                file.walls.push_back({(float) values[0], (float) values[3], (int) values[1], (LineLayer) (int) values[2], (int) values[4], (int) values[5]});
+                break;
+            case ListType::V2Events:
+                if (values[1] == 100)
+                    file.bpmChanges.push_back({(float) values[0], (float) values[2]});
+                break;
+            case ListType::BpmEvents:
+                file.bpmChanges.push_back({(float) values[0], (float) values[1]});
+                break;
+        }
+    }
+
+    static bool ReadList(Scanner& scanner, BeatmapFile& file, ListFormat const& format) {
+        return scanner.ForEachElement([&]() {
+            // missing fields are 0, like the game reads them
+            std::array<double, 6> values{};
+            bool read = scanner.ForEachMember([&](std::string_view key) {
+                for (int i = 0; i < format.fields.size(); i++) {
+                    if (!format.fields[i].empty() && key == format.fields[i]) {
+                        scanner.SkipWhitespace();
+                        // fields of other types are skipped, leaving 0
+                        if (scanner.position < scanner.end && (*scanner.position == '-' || (*scanner.position >= '0' && *scanner.position <= '9')))
+                            return scanner.ReadNumber(values[i]) && std::isfinite(values[i]);
+                        return scanner.SkipValue();
+                    }
+                }
+                return scanner.SkipValue();
+            });
+            if (read)
+                AddItem(file, format.type, values);
+            return read;
+        });
+    }
+
+    std::optional<BeatmapFile> ParseBeatmapFile(std::string_view text) {
+        // utf-8 byte order mark, some map editors write it
+        if (text.starts_with("\xEF\xBB\xBF"))
+            text.remove_prefix(3);
+
+        Scanner scanner{text.data(), text.data() + text.size()};
+        BeatmapFile file{};
+        std::string_view version{};
+        bool hasV3Lists = false;
+
+        bool read = scanner.ForEachMember([&](std::string_view key) {
+            if (key == "version" || key == "_version") {
+                scanner.SkipWhitespace();
+                if (scanner.position < scanner.end && *scanner.position == '"')
+                    return scanner.ReadString(version);
+                return scanner.SkipValue();
+            }
+            for (auto& format : Lists) {
+                if (key == format.name) {
+                    hasV3Lists |= format.type == ListType::ColorNotes || format.type == ListType::BombNotes || format.type == ListType::V3Walls || format.type == ListType::BpmEvents;
+                    return ReadList(scanner, file, format);
+                }
+            }
+            return scanner.SkipValue();
+        });
+        scanner.SkipWhitespace();
+        if (!read || scanner.position != scanner.end)
+            return std::nullopt;
+
+        // v4 lists only refer to the note data in other lists
+        if (version.starts_with("4"))
+            return std::nullopt;
+        file.v3 = version.starts_with("3") || hasV3Lists;
+        return file;
+    }
+
+    std::optional<BeatmapFile> ReadBeatmapFile(std::string const& path) {
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return std::nullopt;
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size == 0) {
+            close(file);
+            return std::nullopt;
+        }
+        size_t size = info.st_size;
+        auto map = (char const*) mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (map == MAP_FAILED)
+            return std::nullopt;
+        // read once from start to end
+        madvise((void*) map, size, MADV_SEQUENTIAL);
+
+        auto result = ParseBeatmapFile(std::string_view(map, size));
+        munmap((void*) map, size);
+        return result;
+    }
+
+    Tempo::Tempo(float bpm, std::vector<BpmChange> changes) {
+        std::stable_sort(changes.begin(), changes.end(), [](auto& a, auto& b) { return a.beat < b.beat; });
+        segments.push_back({0, 0, 60.0 / bpm});
+        for (auto& change : changes) {
+            // the game ignores changes to no bpm, they would stop time
+            if (!(change.bpm > 0))
+                continue;
+            auto& last = segments.back();
+            if (change.beat <= last.beat) {
+                last.secondsPerBeat = 60.0 / change.bpm;
+                continue;
+            }
+            segments.push_back({change.beat, last.seconds + (change.beat - last.beat) * last.secondsPerBeat, 60.0 / change.bpm});
+        }
+    }
+
+    double Tempo::ToSeconds(double beat) const {
+        // times before the first segment use its bpm
+        auto segment = std::upper_bound(segments.begin() + 1, segments.end(), beat, [](double beat, auto& segment) { return beat < segment.beat; }) - 1;
+        return segment->seconds + (beat - segment->beat) * segment->secondsPerBeat;
+    }
+
+    double Tempo::ToBeats(double seconds) const {
+        auto segment = std::upper_bound(segments.begin() + 1, segments.end(), seconds, [](double seconds, auto& segment) { return seconds < segment.seconds; }) - 1;
+        return segment->beat + (seconds - segment->seconds) / segment->secondsPerBeat;
+    }
+
+    void ConvertToSeconds(BeatmapFile& file, float bpm) {
+        Tempo tempo(bpm, file.bpmChanges);
+        for (auto& note : file.notes)
+            note.time = tempo.ToSeconds(note.time);
+        for (auto& wall : file.walls) {
+            // the end moves with the bpm changes the wall spans
+            double start = tempo.ToSeconds(wall.time);
+            wall.duration = tempo.ToSeconds((double) wall.time + wall.duration) - start;
+            wall.time = start;
+        }
+        std::stable_sort(file.notes.begin(), file.notes.end(), [](auto& a, auto& b) { return a.time < b.time; });
+        std::stable_sort(file.walls.begin(), file.walls.end(), [](auto& a, auto& b) { return a.time < b.time; });
+    }
+}
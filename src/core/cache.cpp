@@ -0,0 +1,133 @@
+#include "core/cache.hpp"
+#include "core/hash.hpp"
+
+namespace Generator {
+    uint64_t HashInput(std::span<Note const> notes, std::span<Wall const> walls) {
+        Hasher hasher{};
+        hasher.Add(notes.size());
+        for (auto& note : notes) {
+            hasher.Add(note.time);
+            hasher.Add(note.lineIndex);
+            hasher.Add(note.lineLayer);
+            hasher.Add(note.colorType);
+            hasher.Add(note.cutDirection);
+        }
+        hasher.Add(walls.size());
+        for (auto& wall : walls) {
+            hasher.Add(wall.time);
+            hasher.Add(wall.duration);
+            hasher.Add(wall.lineIndex);
+            hasher.Add(wall.lineLayer);
+            hasher.Add(wall.width);
+            hasher.Add(wall.height);
+        }
+        return hasher.Get();
+    }
+
+    static void AddWalls(Hasher& hasher, std::vector<Wall> const& walls) {
+        hasher.Add(walls.size());
+        for (auto& wall : walls) {
+            hasher.Add(wall.time);
+            hasher.Add(wall.duration);
+            hasher.Add(wall.lineIndex);
+            hasher.Add(wall.lineLayer);
+            hasher.Add(wall.width);
+            hasher.Add(wall.height);
+        }
+    }
+
+    static void AddIndices(Hasher& hasher, std::vector<int> const& indices) {
+        hasher.Add(indices.size());
+        for (int index : indices)
+            hasher.Add(index);
+    }
+
+    uint64_t HashResult(Result const& result) {
+        Hasher hasher{};
+        hasher.Add(result.rotations.size());
+        for (auto& rotation : result.rotations) {
+            hasher.Add(rotation.time);
+            hasher.Add(rotation.amount);
+            hasher.Add(rotation.early);
+        }
+        AddIndices(hasher, result.removedNotes);
+        AddIndices(hasher, result.mirroredNotes);
+        AddIndices(hasher, result.removedWalls);
+        hasher.Add(result.changedWalls.size());
+        for (auto& change : result.changedWalls) {
+            hasher.Add(change.index);
+            hasher.Add(change.time);
+            hasher.Add(change.duration);
+        }
+        AddWalls(hasher, result.generatedWalls);
+        AddWalls(hasher, result.splitWalls);
+        return hasher.Get();
+    }
+
+    size_t CacheKeyHash::operator()(CacheKey const& key) const {
+        Hasher hasher{};
+        hasher.Add(key.levelId);
+        hasher.Add(key.difficulty);
+        hasher.Add(key.basedOn);
+        hasher.Add(key.is90Degree);
+        hasher.Add(key.leftHanded);
+        hasher.Add(key.settingsHash);
+        return hasher.Get();
+    }
+
+    template<class T>
+    static size_t VectorSize(std::vector<T> const& vector) {
+        return vector.capacity() * sizeof(T);
+    }
+
+    size_t ResultSize(Result const& result) {
+        return sizeof(Result) + VectorSize(result.rotations) + VectorSize(result.removedNotes) + VectorSize(result.mirroredNotes) +
+            VectorSize(result.removedWalls) + VectorSize(result.changedWalls) + VectorSize(result.generatedWalls) + VectorSize(result.splitWalls);
+    }
+
+    void ResultCache::Evict() {
+        // keep the newest entry even if it is over the limit on its own, it is about to be used
+        while (usedBytes > maxBytes && entries.size() > 1) {
+            auto& last = entries.back();
+            usedBytes -= last.size;
+            lookup.erase(last.key);
+            entries.pop_back();
+        }
+    }
+
+    void ResultCache::SetMaxBytes(size_t bytes) {
+        maxBytes = bytes;
+        Evict();
+    }
+
+    Result const* ResultCache::Find(CacheKey const& key, uint64_t inputHash) {
+        auto found = lookup.find(key);
+        if (found == lookup.end() || found->second->inputHash != inputHash) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        entries.splice(entries.begin(), entries, found->second);
+        return &found->second->result;
+    }
+
+    Result const& ResultCache::Insert(CacheKey const& key, uint64_t inputHash, Result result) {
+        if (auto found = lookup.find(key); found != lookup.end()) {
+            usedBytes -= found->second->size;
+            entries.erase(found->second);
+            lookup.erase(found);
+        }
+        size_t size = ResultSize(result) + key.levelId.capacity() + key.basedOn.capacity();
+        entries.push_front({key, inputHash, std::move(result), size});
+        lookup.emplace(key, entries.begin());
+        usedBytes += size;
+        Evict();
+        return entries.front().result;
+    }
+
+    void ResultCache::Clear() {
+        entries.clear();
+        lookup.clear();
+        usedBytes = 0;
+    }
+}
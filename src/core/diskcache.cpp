@@ -0,0 +1,220 @@
+#include "core/diskcache.hpp"
+#include "core/hash.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace Generator {
+    static constexpr char Magic[4] = {'3', '6', '0', 'C'};
+    static constexpr int ArrayCount = 7;
+    // temporary files older than this are left from a crash, newer ones can be in use by another writer
+    static constexpr auto StaleTemporaryAge = std::chrono::minutes(10);
+
+    // numbers the temporary files, so saves of the same key from several threads never write to the same file
+    static std::atomic<uint32_t> nextTemporary = 0;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t levelHash;
+        uint64_t settingsHash;
+        uint64_t inputHash;
+        int32_t difficulty;
+        uint32_t counts[ArrayCount];
+        uint64_t payloadHash;
+    };
+
+    // the arrays are written as is, so their layout is part of the format
+    static_assert(std::is_trivially_copyable_v<Rotation> && sizeof(Rotation) == 12);
+    static_assert(std::is_trivially_copyable_v<WallChange> && sizeof(WallChange) == 12);
+    static_assert(std::is_trivially_copyable_v<Wall> && sizeof(Wall) == 24);
+    static_assert(sizeof(FileHeader) % alignof(Wall) == 0);
+
+    // calls the function on every array of the result, in file order
+    template<class R, class F>
+    static void ForEachArray(R& result, F&& function) {
+        function(result.rotations);
+        function(result.removedNotes);
+        function(result.mirroredNotes);
+        function(result.removedWalls);
+        function(result.changedWalls);
+        function(result.generatedWalls);
+        function(result.splitWalls);
+    }
+
+    static uint64_t LevelHash(CacheKey const& key) {
+        Hasher hasher{};
+        hasher.Add(key.levelId);
+        return hasher.Get();
+    }
+
+    static uint64_t SettingsHash(CacheKey const& key) {
+        Hasher hasher{};
+        hasher.Add(key.basedOn);
+        hasher.Add(key.is90Degree);
+        hasher.Add(key.leftHanded);
+        hasher.Add(key.settingsHash);
+        return hasher.Get();
+    }
+
+    std::string DiskCache::GetPath(CacheKey const& key) const {
+        char name[64];
+        snprintf(name, sizeof(name), "%016llx-%d-%016llx.bin", (unsigned long long) LevelHash(key), key.difficulty, (unsigned long long) SettingsHash(key));
+        return (fs::path(directory) / name).string();
+    }
+
+    std::optional<Result> DiskCache::Load(CacheKey const& key, uint64_t inputHash) const {
+        auto path = GetPath(key);
+
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return std::nullopt;
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size < sizeof(FileHeader)) {
+            close(file);
+            remove(path.c_str());
+            return std::nullopt;
+        }
+        size_t size = info.st_size;
+        auto map = (char const*) mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (map == MAP_FAILED)
+            return std::nullopt;
+
+        auto Reject = [&](bool corrupted) -> std::optional<Result> {
+            munmap((void*) map, size);
+            if (corrupted)
+                remove(path.c_str());
+            return std::nullopt;
+        };
+
+        auto header = (FileHeader const*) map;
+        if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != DiskCacheVersion)
+            return Reject(true);
+        if (header->levelHash != LevelHash(key) || header->settingsHash != SettingsHash(key) || header->difficulty != key.difficulty)
+            return Reject(true);
+        // same level, but different notes (from modifiers or an updated map), will be overwritten if regenerated
+        if (header->inputHash != inputHash)
+            return Reject(false);
+
+        Result result{};
+        size_t expectedSize = sizeof(FileHeader);
+        int index = 0;
+        ForEachArray(result, [&](auto& vector) {
+            expectedSize += (size_t) header->counts[index++] * sizeof(vector[0]);
+        });
+        if (expectedSize != size)
+            return Reject(true);
+
+        Hasher hasher{};
+        hasher.AddBytes(map + sizeof(FileHeader), size - sizeof(FileHeader));
+        if (hasher.Get() != header->payloadHash)
+            return Reject(true);
+
+        auto position = map + sizeof(FileHeader);
+        index = 0;
+        ForEachArray(result, [&](auto& vector) {
+            using T = std::remove_reference_t<decltype(vector[0])>;
+            auto count = header->counts[index++];
+            vector.resize(count);
+            memcpy(vector.data(), position, count * sizeof(T));
+            position += count * sizeof(T);
+        });
+        munmap((void*) map, size);
+
+        // mark as recently used for eviction
+        std::error_code error;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+        return result;
+    }
+
+    bool DiskCache::Save(CacheKey const& key, uint64_t inputHash, Result const& result) const {
+        std::error_code error;
+        fs::create_directories(directory, error);
+
+        FileHeader header{};
+        memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = DiskCacheVersion;
+        header.levelHash = LevelHash(key);
+        header.settingsHash = SettingsHash(key);
+        header.inputHash = inputHash;
+        header.difficulty = key.difficulty;
+
+        std::vector<char> payload{};
+        int index = 0;
+        ForEachArray(result, [&](auto& vector) {
+            header.counts[index++] = vector.size();
+            auto bytes = (char const*) vector.data();
+            payload.insert(payload.end(), bytes, bytes + vector.size() * sizeof(vector[0]));
+        });
+        Hasher hasher{};
+        hasher.AddBytes(payload.data(), payload.size());
+        header.payloadHash = hasher.Get();
+
+        // write to a temporary file first so a partial write is never loaded, the last rename wins
+        auto path = GetPath(key);
+        auto temporaryPath = path + "." + std::to_string(getpid()) + "." + std::to_string(nextTemporary++) + ".tmp";
+        auto file = fopen(temporaryPath.c_str(), "wb");
+        if (!file)
+            return false;
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (!payload.empty())
+            written = written && fwrite(payload.data(), payload.size(), 1, file) == 1;
+        written = fclose(file) == 0 && written;
+        if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            remove(temporaryPath.c_str());
+            return false;
+        }
+
+        Evict();
+        return true;
+    }
+
+    void DiskCache::Evict() const {
+        struct File {
+            fs::path path;
+            size_t size;
+            fs::file_time_type lastUsed;
+        };
+        std::vector<File> files{};
+        size_t totalSize = 0;
+
+        std::error_code error;
+        auto now = fs::file_time_type::clock::now();
+        for (auto& entry : fs::directory_iterator(directory, error)) {
+            if (!entry.is_regular_file(error))
+                continue;
+            if (entry.path().extension() == ".tmp" && now - entry.last_write_time(error) > StaleTemporaryAge) {
+                fs::remove(entry.path(), error);
+                continue;
+            }
+            if (entry.path().extension() != ".bin")
+                continue;
+            File file{entry.path(), (size_t) entry.file_size(error), entry.last_write_time(error)};
+            totalSize += file.size;
+            files.emplace_back(std::move(file));
+        }
+        if (totalSize <= maxBytes)
+            return;
+
+        std::sort(files.begin(), files.end(), [](File const& a, File const& b) { return a.lastUsed < b.lastUsed; });
+        for (auto& file : files) {
+            if (totalSize <= maxBytes)
+                break;
+            if (fs::remove(file.path, error))
+                totalSize -= file.size;
+        }
+    }
+}
@@ -0,0 +1,1305 @@
+// copied and adapted to C++ from https://github.com/CodeStix/Beat-360fyer-Plugin/blob/master/Beat-360fyer-Plugin/Generator360.cs
+
+#include "core/generator.hpp"
+#include "core/arena.hpp"
+#include "core/kernels.hpp"
+#include "core/stats.hpp"
+#include "core/threadpool.hpp"
+#include "core/trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <optional>
+
+namespace Generator {
+    // sorted start times of walls with the latest end time up to each of them
+    // answers if any wall overlaps a time range in O(log n)
+    class WallIndex {
+        ArenaVector<float> starts;
+        ArenaVector<float> maxEnds;
+
+        public:
+        // the order of walls with the same start doesn't matter, they are all counted or none are
+        WallIndex(std::span<Wall const> walls, std::span<int const> byTime, Arena& arena) : starts(arena), maxEnds(arena) {
+            starts.reserve(byTime.size());
+            maxEnds.reserve(byTime.size());
+            for (int index : byTime) {
+                float end = walls[index].time + walls[index].duration;
+                starts.emplace_back(walls[index].time);
+                maxEnds.emplace_back(maxEnds.empty() ? end : std::max(maxEnds.back(), end));
+            }
+        }
+
+        // same as checking wall.time + wall.duration >= time && wall.time < time + duration for every wall
+        bool AnyOverlapping(float time, float duration) const {
+            // walls starting before the end of the range
+            auto count = std::lower_bound(starts.begin(), starts.end(), time + duration) - starts.begin();
+            return count > 0 && maxEnds[count - 1] >= time;
+        }
+    };
+
+    void Mirror(Note& note, int numberOfLines) {
+        note.lineIndex = numberOfLines - 1 - note.lineIndex;
+        if (note.colorType != ColorType::None)
+            note.colorType = note.colorType == ColorType::ColorA ? ColorType::ColorB : ColorType::ColorA;
+        switch (note.cutDirection) {
+            case CutDirection::Left: note.cutDirection = CutDirection::Right; break;
+            case CutDirection::Right: note.cutDirection = CutDirection::Left; break;
+            case CutDirection::UpLeft: note.cutDirection = CutDirection::UpRight; break;
+            case CutDirection::UpRight: note.cutDirection = CutDirection::UpLeft; break;
+            case CutDirection::DownLeft: note.cutDirection = CutDirection::DownRight; break;
+            case CutDirection::DownRight: note.cutDirection = CutDirection::DownLeft; break;
+            default: break;
+        }
+    }
+
+    void Mirror(Wall& wall, int numberOfLines) {
+        wall.lineIndex = numberOfLines - wall.width - wall.lineIndex;
+    }
+
+    struct Cut {
+        float time;
+        int multiplier;
+    };
+
+    struct Fragment {
+        Wall wall;
+        bool removed;
+    };
+
+    // more than enough for the pieces of one wall, it only has pieces between the cuts near it
+    static constexpr int FragmentsReserve = 16;
+
+    // subtracts the margins around each cut from a wall, leaving the remaining pieces in fragments
+    // the cuts must be in time order and on the side of the wall
+    static void CutWall(ArenaVector<Fragment>& fragments, std::span<Cut const> cuts, Params const& params) {
+        float frontCut = params.wallFrontCut;
+        float backCut = params.wallBackCut;
+        float minWallDur = params.minWallDuration;
+        // rotations are at most 4 steps
+        float maxBackCut = std::max(backCut, backCut * 4);
+
+        for (auto& [cutTime, cutMultiplier] : cuts) {
+            bool reachable = false;
+            int count = fragments.size();
+            for (int i = 0; i < count; i++) {
+                // pieces that were removed or have no duration left are not cut further
+                if (fragments[i].removed || fragments[i].wall.duration <= 0)
+                    continue;
+                auto& wall = fragments[i].wall;
+                if (cutTime < wall.time + wall.duration + maxBackCut)
+                    reachable = true;
+
+                if (!(cutTime > wall.time - frontCut && cutTime < wall.time + wall.duration + backCut * cutMultiplier))
+                    continue;
+
+                float originalTime = wall.time;
+                float originalDuration = wall.duration;
+
+                float firstPartTime = wall.time;
+                float firstPartDuration = (cutTime - backCut * cutMultiplier) - firstPartTime;
+                float secondPartTime = cutTime + frontCut;
+                float secondPartDuration = (wall.time + wall.duration) - secondPartTime;
+
+                // update duration of existing obstacle
+                if (firstPartDuration >= minWallDur && secondPartDuration >= minWallDur) {
+                    wall.duration = firstPartDuration;
+
+                    // And create a new obstacle after it
+                    Wall secondPart = {secondPartTime, secondPartDuration, wall.lineIndex, wall.lineLayer, wall.width, wall.height};
+                    fragments.push_back({secondPart, false});
+                }
+                // just update the existing obstacle, the second piece of the cut wall is too small
+                else if (firstPartDuration >= minWallDur)
+                    wall.duration = firstPartDuration;
+                // Reuse the obstacle and use it as second part
+                else if (secondPartDuration >= minWallDur) {
+                    if (secondPartTime != wall.time && secondPartDuration != wall.duration) {
+                        wall.time = secondPartTime;
+                        wall.duration = secondPartDuration;
+                    }
+                }
+                // When this wall is cut, both pieces are too small, remove it
+                else
+                    fragments[i].removed = true;
+
+                GENERATOR_TRACE(Verbose, "Split wall at %.2f: %.2f(%.2f) -> %.2f(%.2f) <|> %.2f(%.2f) cutMultiplier=%d",
+                    cutTime, originalTime, originalDuration, firstPartTime, firstPartDuration, secondPartTime, secondPartDuration, cutMultiplier);
+            }
+            // the cuts are in time order, so no later cut can reach the pieces either
+            if (!reachable)
+                break;
+        }
+    }
+
+    // if a bomb at this time is within the margins of any of the cuts, which must be in time order
+    // the cursor skips cuts that are too early for this and any later bomb
+    static bool AnyCutNear(float time, std::span<Cut const> cuts, int& cursor, Params const& params) {
+        while (cursor < cuts.size() && !(time < cuts[cursor].time + params.wallBackCut))
+            cursor++;
+        for (int i = cursor; i < cuts.size() && cuts[i].time - params.wallFrontCut <= time; i++) {
+            if (time >= cuts[i].time - params.wallFrontCut && time < cuts[i].time + params.wallBackCut)
+                return true;
+        }
+        return false;
+    }
+
+    // a bar of the notes, with everything about it that doesn't depend on the rotations before it
+    struct Bar {
+        // relative to the first note
+        float start;
+        float end;
+        int startTick;
+        // first note of the next bar
+        int nextNote;
+        // non bomb notes in Analysis::barNotes
+        int firstNote;
+        int noteCount;
+        bool allSameTime;
+        // notes pointing left and right, only counted if a spin is possible
+        int leftCount;
+        int rightCount;
+        int barDivider;
+        // in Analysis::segments, some can be empty
+        int firstSegment;
+        int segmentCount;
+    };
+
+    // one of the barDivider pieces of a bar, a rotation can be emitted after its last note
+    struct Segment {
+        // in Analysis::barNotes
+        int firstNote;
+        int noteCount;
+        float lastNoteTime;
+        // notes pointing left and right near the last note
+        int leftCount;
+        int rightCount;
+        int lastNotesCount;
+        // the note after the segment, -1 if there is none
+        int afterLastNote;
+        int rotationCount;
+        // lanes with notes, before any are mirrored
+        int lanes;
+    };
+
+    // what the bar loop finds in the notes, the same for params that only differ in the rotation limits
+    // a session either analyzes each bar just before deciding its rotations, or uses an analysis of all bars made up front
+    struct Analysis {
+        // note times are rounded once to a grid of ticks, a power of two per bar so bars and segments are found with shifts
+        // notes on the same tick are at the same time, rounding also puts notes just before a bar in it like the original did
+        static constexpr int TickBits = 10;
+        static constexpr int TicksPerBar = 1 << TickBits;
+
+        float beatDuration;
+        float barLength;
+        // align bars to first note, the first note (almost always) identifies the start of the first bar
+        float firstBeatmapNoteTime = 0;
+        double ticksPerSecond;
+        // the last notes of a segment are within this many ticks of its last note
+        int lastNotesTicks;
+        // notes this many ticks apart are still at the same time, two notes just either side of a tick edge round to neighboring ticks
+        static constexpr int SameTimeTicks = 1;
+        // first note not in a bar yet
+        int nextNote = 0;
+
+        ArenaVector<Bar> bars;
+        // barDivider slots for each bar, the ones after segmentCount are unused
+        ArenaVector<Segment> segments;
+        // note indices, and their ticks
+        ArenaVector<int> barNotes;
+        ArenaVector<int> barTicks;
+
+        Analysis(Arena& arena) : bars(arena), segments(arena), barNotes(arena), barTicks(arena) {}
+
+        void SetTiming(float beatDuration, float barLength, float firstBeatmapNoteTime) {
+            this->beatDuration = beatDuration;
+            this->barLength = barLength;
+            this->firstBeatmapNoteTime = firstBeatmapNoteTime;
+            ticksPerSecond = TicksPerBar / (double) barLength;
+            lastNotesTicks = std::lround(0.005 * ticksPerSecond);
+        }
+
+        int Tick(float time) const {
+            return std::lround((time - firstBeatmapNoteTime) * ticksPerSecond);
+        }
+
+        // relative to the first note
+        float BarStart(int tick) const {
+            return (tick >> TickBits) * barLength;
+        }
+
+        // keeps the position, for analyzing one bar at a time
+        void Clear() {
+            bars.clear();
+            segments.clear();
+            barNotes.clear();
+            barTicks.clear();
+        }
+    };
+
+    // the notes of a bar packed for the kernels, reused for each bar
+    struct BarBuffers {
+        ArenaVector<uint8_t> directions;
+        ArenaVector<int> lines;
+
+        BarBuffers(Arena& arena, size_t maxBarNotes) : directions(arena), lines(arena) {
+            directions.reserve(maxBarNotes);
+            lines.reserve(maxBarNotes);
+        }
+
+        static size_t Size(size_t maxBarNotes) {
+            return maxBarNotes * (sizeof(uint8_t) + sizeof(int)) + 64;
+        }
+    };
+
+    // align beat duration to between 75% and 150% of preferred
+    static float BarLength(Params const& params) {
+        float beatDuration = 60 / params.bpm;
+        float preferredDuration = params.preferredBarDuration;
+
+        float barLength = beatDuration;
+        while (barLength >= preferredDuration * 1.5)
+            barLength /= 2;
+        while (barLength < preferredDuration * 0.75)
+            barLength *= 2;
+        return barLength;
+    }
+
+    // finds the notes of the next bar, this part is serial since each bar starts at the first note after the one before
+    static Bar& FindBar(Analysis& analysis, std::span<Note const> notes) {
+        int& i = analysis.nextNote;
+
+        // find the start and end of the current bar, discarding offset by using the first note
+        int startTick = analysis.Tick(notes[i].time) >> Analysis::TickBits << Analysis::TickBits;
+        int endTick = startTick + Analysis::TicksPerBar;
+        float currentBarStart = analysis.BarStart(startTick);
+
+        Bar bar{currentBarStart, currentBarStart + analysis.barLength, startTick};
+        bar.firstNote = analysis.barNotes.size();
+
+        // get all the non bomb notes in the current bar
+        for (; i < notes.size(); i++) {
+            int tick = analysis.Tick(notes[i].time);
+            if (tick >= endTick)
+                break;
+            // not bomb
+            if (notes[i].cutDirection != CutDirection::None) {
+                analysis.barNotes.emplace_back(i);
+                analysis.barTicks.emplace_back(tick);
+            }
+        }
+        bar.nextNote = i;
+        bar.noteCount = analysis.barNotes.size() - bar.firstNote;
+
+        // divide the current bar in x pieces (or notes), for each piece, a rotation event CAN be emitted
+        // calculated from the amount of notes in the current bar
+        // barDivider | rotations
+        // 0          | . . . . (no rotations)
+        // 1          | r . . . (only on first beat)
+        // 2          | r . r . (on first and third beat)
+        // 4          | r r r r
+        // 8          | rrrrrrrr
+        // ...        | ...
+        // TODO: create formula out of these if statements
+        if (bar.noteCount == 0)
+            bar.barDivider = 0;
+        else if (bar.noteCount >= 58)
+            bar.barDivider = 0; // too many notes, do not rotate
+        else if (bar.noteCount >= 38)
+            bar.barDivider = 1;
+        else if (bar.noteCount >= 26)
+            bar.barDivider = 2;
+        else if (bar.noteCount >= 8)
+            bar.barDivider = 4;
+        else
+            bar.barDivider = 8;
+
+        bar.firstSegment = analysis.segments.size();
+        analysis.segments.resize(analysis.segments.size() + bar.barDivider);
+        analysis.bars.push_back(bar);
+        return analysis.bars.back();
+    }
+
+    // everything else about a found bar, it only writes to the bar and its segments so bars can be done in parallel
+    static void ExtractFeatures(Analysis& analysis, std::span<Note const> notes, Bar& bar, BarBuffers& buffers) {
+        if (bar.noteCount == 0)
+            return;
+
+        auto barNotes = std::span(analysis.barNotes).subspan(bar.firstNote, bar.noteCount);
+        auto barTicks = std::span(analysis.barTicks).subspan(bar.firstNote, bar.noteCount);
+
+        auto& barDirections = buffers.directions;
+        auto& barLines = buffers.lines;
+        barDirections.clear();
+        barLines.clear();
+        for (int index : barNotes) {
+            barDirections.emplace_back((uint8_t) notes[index].cutDirection);
+            barLines.emplace_back(notes[index].lineIndex);
+        }
+
+        // find if all the notes are basically at the same time, to determine if we do a spin
+        bar.allSameTime = Kernels::AllNear(barTicks.data(), bar.noteCount, barTicks[0], Analysis::SameTimeTicks);
+        if (bar.allSameTime && bar.noteCount >= 2) {
+            auto counts = Kernels::CountDirections(barDirections.data(), barDirections.size());
+            bar.leftCount = counts.left;
+            bar.rightCount = counts.right;
+        }
+
+        // iterate all the notes in the current bar in barDiviver pieces (bar is split in barDiviver pieces)
+        int segmentBits = Analysis::TickBits - std::countr_zero((unsigned) std::max(bar.barDivider, 1));
+        int j = 0;
+        for (int k = 0; j < bar.barDivider && k < bar.noteCount; j++) {
+            // find all the notes in the current division of the bar, the ticks are sorted
+            int segmentStart = k;
+            k += Kernels::CountBelow(barTicks.data() + k, bar.noteCount - k, bar.startTick + ((j + 1) << segmentBits));
+            int segmentSize = k - segmentStart;
+
+            auto& segment = analysis.segments[bar.firstSegment + j];
+            segment = {bar.firstNote + segmentStart, segmentSize};
+            if (segmentSize == 0)
+                continue;
+
+            // determine the rotation direction based on the last notes in the bar
+            float lastNoteTime = notes[barNotes[k - 1]].time;
+            segment.lastNoteTime = lastNoteTime;
+
+            // amount of notes pointing to the left/right of the last notes in the bar segment
+            int lastTick = barTicks[k - 1];
+            auto counts = Kernels::CountDirectionsNear(
+                barTicks.data() + segmentStart, barDirections.data() + segmentStart, segmentSize, lastTick, analysis.lastNotesTicks);
+            segment.leftCount = counts.left;
+            segment.rightCount = counts.right;
+            segment.lastNotesCount = counts.count;
+
+            // the next note after the bar segment
+            segment.afterLastNote = k < bar.noteCount ? barNotes[k] : bar.nextNote < notes.size() ? bar.nextNote : -1;
+
+            // determine amount to rotate at once
+            // TODO: create formula out of these if statements
+            segment.rotationCount = 1;
+            if (segment.afterLastNote >= 0) {
+                // in seconds rather than ticks, a gap of exactly a bar or an eighth of one is often just short of it in floats
+                // on the tick grid it always counted, which made about a sixth of the rotations of on grid maps bigger
+                float timeDiff = notes[segment.afterLastNote].time - lastNoteTime;
+                // only rotate once if there is only one note in the current bar segment
+                if (segmentSize >= 1) {
+                    // rotate thrice if you have an entire bar to react
+                    if (timeDiff >= analysis.barLength)
+                        segment.rotationCount = 3;
+                    // rotate twice if you have an eighth of a bar to react
+                    else if (timeDiff >= analysis.barLength / 8)
+                        segment.rotationCount = 2;
+                }
+            }
+
+            segment.lanes = Kernels::LaneMask(barLines.data() + segmentStart, segmentSize);
+        }
+        bar.segmentCount = j;
+    }
+
+    // finds all the bars, then extracts their features in parallel if there is a pool
+    static void AnalyzeAll(Analysis& analysis, std::span<Note const> notes, size_t maxBarNotes, ThreadPool* pool) {
+        while (analysis.nextNote < notes.size())
+            FindBar(analysis, notes);
+
+        // enough chunks for the workers to even out, few enough that each has many bars
+        int chunkCount = pool ? std::min<int>(pool->GetThreadCount() * 4, analysis.bars.size() / 16) : 1;
+        chunkCount = std::max(chunkCount, 1);
+        auto ExtractChunk = [&analysis, notes, maxBarNotes, chunkCount](int chunk) {
+            Arena arena(BarBuffers::Size(maxBarNotes));
+            BarBuffers buffers(arena, maxBarNotes);
+            size_t first = analysis.bars.size() * chunk / chunkCount;
+            size_t last = analysis.bars.size() * (chunk + 1) / chunkCount;
+            for (size_t i = first; i < last; i++)
+                ExtractFeatures(analysis, notes, analysis.bars[i], buffers);
+        };
+        if (chunkCount == 1)
+            ExtractChunk(0);
+        else
+            pool->ParallelFor(chunkCount, ExtractChunk);
+    }
+
+    // larger than any rotation difference, for ranges of rotations open on one side
+    static constexpr int Unbounded = 1 << 24;
+
+    // what the rotations of a bar depend on from the bars before it
+    struct Carried {
+        // current rotation
+        int totalRotation = 0;
+        // previous spin direction, false is left, true is right
+        bool previousDirection = true;
+        float previousSpinTime = -1;
+    };
+
+    // everything carried from one bar to the next, so generation can stop between bars and continue later
+    struct SessionState {
+        // all the scratch memory below, the result is not in it since it is handed out
+        Arena arena;
+
+        Params params;
+        Stats* stats;
+
+        // working copy, notes can be mirrored during generation
+        ArenaVector<Note> notes{arena};
+        ArenaVector<Wall> walls{arena};
+        Result result{};
+
+        // TODO
+        bool containsCustomWalls = false;
+
+        // amount of rotation events emitted
+        int eventCount = 0;
+        Carried carried{};
+
+        float beatDuration;
+        float barLength;
+        float firstBeatmapNoteTime;
+        // first note of the next bar
+        int nextNote = 0;
+
+        // bars are analyzed one at a time into the own analysis, unless a shared one was given
+        Analysis ownAnalysis{arena};
+        Analysis const* analysis = &ownAnalysis;
+        std::optional<BarBuffers> barBuffers{};
+        // next bar in the analysis
+        int nextBar = 0;
+        // decides chunks of bars in parallel if given, only used with a shared analysis
+        ThreadPool* pool = nullptr;
+
+        // only the original walls are checked when generating new ones
+        std::optional<WallIndex> existingWalls{};
+
+        // moments where a wall should be cut
+        // a wall is only cut by rotations towards its side, so each side gets its own list
+        // sorted by time up to sortedLeftCuts and sortedRightCuts, new cuts are added after that
+        int cutCount = 0;
+        ArenaVector<Cut> leftCuts{arena};
+        ArenaVector<Cut> rightCuts{arena};
+        int sortedLeftCuts = 0;
+        int sortedRightCuts = 0;
+
+        // walls that haven't been cut yet, in time order
+        // a long wall doesn't hold back the ones after it, so they can be cut before it when streaming
+        ArenaVector<int> pendingWalls{arena};
+        ArenaVector<Fragment> fragments{arena};
+
+        // next note to check for bombs near cuts
+        int nextBomb = 0;
+        int leftBombCursor = 0;
+        int rightBombCursor = 0;
+
+        // amount of each result list already returned by TakeCompleted
+        int takenRotations = 0;
+        int takenRemovedNotes = 0;
+        int takenMirroredNotes = 0;
+        int takenRemovedWalls = 0;
+        int takenChangedWalls = 0;
+        int takenGeneratedWalls = 0;
+        int takenSplitWalls = 0;
+
+        // the bar loop, specialized for the modes in the params
+        void (*runBars)(SessionState& state, float time, std::chrono::steady_clock::time_point deadline);
+
+        SessionState(size_t arenaSize) : arena(arenaSize) {}
+
+        void Mirrored(int index) {
+            Mirror(notes[index], params.numberOfLines);
+            result.mirroredNotes.emplace_back(index);
+        }
+
+        // only chunks keep track of the rotations their decisions hold for
+        void Constrain(int, int) {}
+
+        static constexpr bool KeepsEdits = true;
+
+        bool BarsDone() const {
+            return nextNote >= notes.size();
+        }
+
+        // no cut made by a later bar can be before this time
+        float CutFrontier() const {
+            if (BarsDone())
+                return INFINITY;
+            float nextBarStart = analysis->BarStart(analysis->Tick(notes[nextNote].time));
+            return std::min(notes[nextNote].time, firstBeatmapNoteTime + nextBarStart);
+        }
+
+        // the notes, walls and bombs before this time have all their edits
+        float CompletedTime() const {
+            float time = CutFrontier();
+            if (!pendingWalls.empty())
+                time = std::min(time, walls[pendingWalls.front()].time);
+            if (nextBomb < notes.size())
+                time = std::min(time, notes[nextBomb].time);
+            return time;
+        }
+
+        void CutWalls(float frontier);
+        void ClearBombs(float frontier);
+    };
+
+    // bars decided apart from the session, starting from a guessed carried state
+    // appended to the session once the bars before them are decided, from the first bar where the real carried state matches
+    // the rotation doesn't need to match exactly, most decisions are the same for a range of rotations and so are the edits
+    struct Chunk {
+        // the carried state and list sizes after a bar
+        struct Mark {
+            // the differences to the guessed rotation the decisions of the bar hold for
+            int low;
+            int high;
+            Carried carried;
+            int eventCount;
+            int cutCount;
+            int rotations;
+            int leftCuts;
+            int rightCuts;
+            int removedNotes;
+            int mirroredNotes;
+            int generatedWalls;
+        };
+
+        int firstBar;
+        int endBar;
+
+        Carried carried{};
+        int low = -Unbounded;
+        int high = Unbounded;
+        // separate from the session's while decided in parallel, added to it once the chunks are joined
+        Stats* stats = nullptr;
+        int eventCount = 0;
+        int cutCount = 0;
+        std::vector<Cut> leftCuts{};
+        std::vector<Cut> rightCuts{};
+        Result result{};
+        std::vector<Mark> marks{};
+
+        static constexpr bool KeepsEdits = true;
+
+        // the notes are mirrored when the chunk is appended
+        void Mirrored(int index) {
+            result.mirroredNotes.emplace_back(index);
+        }
+
+        // a decision was made that is the same for total rotations from low to high
+        void Constrain(int low, int high) {
+            this->low = std::max(this->low, low - carried.totalRotation);
+            this->high = std::min(this->high, high - carried.totalRotation);
+        }
+
+        void AddMark() {
+            marks.push_back({low, high, carried, eventCount, cutCount, (int) result.rotations.size(), (int) leftCuts.size(), (int) rightCuts.size(),
+                (int) result.removedNotes.size(), (int) result.mirroredNotes.size(), (int) result.generatedWalls.size()});
+            low = -Unbounded;
+            high = Unbounded;
+        }
+    };
+
+    // only follows the carried state through bars, to find where the chunks really start without deciding their edits
+    struct Trajectory {
+        Carried carried;
+        Stats* stats = nullptr;
+
+        static constexpr bool KeepsEdits = false;
+
+        void Constrain(int, int) {}
+    };
+
+    // adds a rotation event to the session or a chunk, limited to the rotation limit unless it's part of a spin
+    template<class Target>
+    static void Rotate(Target& target, int rotLimit, float time, int amount, bool early, bool enableLimit = true) {
+        auto& totalRotation = target.carried.totalRotation;
+
+        if (amount == 0)
+            return;
+        if (amount < -4)
+            amount = -4;
+        if (amount > 4)
+            amount = 4;
+
+        if (enableLimit) {
+            // the limited amount is the same for any rotation that doesn't reach the limit, or that is already past it
+            if (amount > 0 && totalRotation + amount > rotLimit)
+                target.Constrain(totalRotation >= rotLimit ? rotLimit : totalRotation, totalRotation >= rotLimit ? Unbounded : totalRotation);
+            else if (amount > 0)
+                target.Constrain(-Unbounded, rotLimit - amount);
+            else if (totalRotation + amount < -rotLimit)
+                target.Constrain(totalRotation <= -rotLimit ? -Unbounded : totalRotation, totalRotation <= -rotLimit ? -rotLimit : totalRotation);
+            else
+                target.Constrain(-rotLimit - amount, Unbounded);
+
+            if (totalRotation + amount > rotLimit)
+                amount = std::min(amount, std::max(0, rotLimit - totalRotation));
+            else if (totalRotation + amount < -rotLimit)
+                amount = std::max(amount, std::min(0, -(rotLimit + totalRotation)));
+            if (amount == 0)
+                return;
+
+            totalRotation += amount;
+        }
+
+        target.carried.previousDirection = amount > 0;
+        if constexpr (Target::KeepsEdits) {
+            target.eventCount++;
+            target.cutCount++;
+            if (amount < 0)
+                target.leftCuts.push_back({time, -amount});
+            else
+                target.rightCuts.push_back({time, amount});
+
+            target.result.rotations.push_back({time, amount, early});
+        }
+    }
+
+    // decides the rotations of a bar and what they do to the notes and walls
+    // the boolean modes are template arguments so the disabled ones are compiled out of the bar loop
+    // the edits go to the target, which is the session itself or a chunk
+    template<bool EnableSpin, bool WallGenerator, bool OnlyOneSaber, class Target>
+    static void DecideBar(SessionState const& state, Target& target, Bar const& bar) {
+        auto& params = state.params;
+        auto& notes = state.notes;
+        auto& analysis = *state.analysis;
+        auto& totalRotation = target.carried.totalRotation;
+        auto& previousDirection = target.carried.previousDirection;
+        auto& previousSpinTime = target.carried.previousSpinTime;
+        float firstBeatmapNoteTime = state.firstBeatmapNoteTime;
+        float barLength = state.barLength;
+        float beatDuration = state.beatDuration;
+        float currentBarStart = bar.start;
+        float currentBarEnd = bar.end;
+        int rotLimit = params.rotationLimit;
+        auto stats = target.stats;
+
+        // no rotations if no notes
+        if (bar.noteCount == 0)
+            return;
+
+        // spin around if there are 2+ notes at the same time, respecting the cooldown
+        if (EnableSpin && bar.noteCount >= 2 && currentBarStart - previousSpinTime > params.spinCooldown && bar.allSameTime) {
+            ScopedTimer spinTimer(stats ? &stats->spinTime : nullptr);
+            GENERATOR_TRACE(Debug, "Generator | Spin effect at %.2f", firstBeatmapNoteTime + currentBarStart);
+
+            // determine the spin direction based on which way the notes are pointing
+            // continuing the last direction if they are equal
+            int spinDirection;
+            if (bar.leftCount == bar.rightCount)
+                spinDirection = previousDirection ? -1 : 1;
+            else if (bar.leftCount > bar.rightCount)
+                spinDirection = -1;
+            else
+                spinDirection = 1;
+
+            float spinStep = params.totalSpinTime / 24;
+            for (int s = 0; s < 24; s++)
+                Rotate(target, rotLimit, firstBeatmapNoteTime + currentBarStart + spinStep * s, spinDirection, true, false);
+
+            // do not emit more rotation events after this
+            previousSpinTime = currentBarStart;
+            return;
+        }
+
+        int barDivider = bar.barDivider;
+        if (barDivider <= 0)
+            return;
+
+        // note counts of each segment for the trace, at most 8 segments of up to 57 notes
+        char segments[32] = "";
+        int segmentsLength = 0;
+        bool traceSegments = TraceEnabled(TraceLevel::Debug);
+
+        float dividedBarLength = barLength / barDivider;
+        for (int j = 0; j < bar.segmentCount; j++) {
+            auto& segment = analysis.segments[bar.firstSegment + j];
+            auto notesInBarBeat = std::span(analysis.barNotes).subspan(segment.firstNote, segment.noteCount);
+
+            if (traceSegments)
+                segmentsLength += snprintf(segments + segmentsLength, sizeof(segments) - segmentsLength, j != 0 ? ",%lu" : "%lu", notesInBarBeat.size());
+
+            if (notesInBarBeat.size() == 0)
+                continue;
+
+            float currentBarBeatStart = firstBeatmapNoteTime + currentBarStart + j * dividedBarLength;
+            float lastNoteTime = segment.lastNoteTime;
+            int leftCount = segment.leftCount;
+            int rightCount = segment.rightCount;
+            Note const* afterLastNote = segment.afterLastNote >= 0 ? &notes[segment.afterLastNote] : nullptr;
+            int rotationCount = segment.rotationCount;
+
+            int bottleneckRotations = params.bottleneckRotations;
+
+            int rotation = 0;
+            // most of the notes at the end are pointing to the left, rotate to the left
+            if (leftCount > rightCount)
+                rotation = -rotationCount;
+            // most of the notes at the end are pointing to the right, rotate to the right
+            else if (rightCount > leftCount)
+                rotation = rotationCount;
+            // equal direction in the last notes of the bar
+            else {
+                // prefer rotating to the left if moved a lot to the right
+                if (totalRotation >= bottleneckRotations) {
+                    rotation = -rotationCount;
+                    target.Constrain(bottleneckRotations, Unbounded);
+                }
+                // prefer rotating to the right if moved a lot to the left
+                else if (totalRotation <= -bottleneckRotations) {
+                    rotation = rotationCount;
+                    target.Constrain(-Unbounded, std::min(bottleneckRotations - 1, -bottleneckRotations));
+                }
+                // rotate based on previous direction
+                else {
+                    rotation = previousDirection ? rotationCount : -rotationCount;
+                    target.Constrain(-bottleneckRotations + 1, bottleneckRotations - 1);
+                }
+            }
+
+            // don't rotate more than once (15 degrees) if rotating the other direction is preferred
+            if (totalRotation >= bottleneckRotations && rotationCount > 1)
+                rotationCount = 1;
+            else if (totalRotation <= -bottleneckRotations && rotationCount < -1)
+                rotationCount = -1;
+
+            // always rotate the other direction if past the rotation limit
+            if (totalRotation >= rotLimit - 1 && rotationCount > 0)
+                rotationCount = -rotationCount;
+            else if (totalRotation <= -rotLimit + 1 && rotationCount < 0)
+                rotationCount = -rotationCount;
+
+            // finally rotate after the last note with the calculated values
+            Rotate(target, rotLimit, lastNoteTime, rotation, false);
+
+            int lanes = segment.lanes;
+            // TODO: change to preserve parity
+            if constexpr (OnlyOneSaber) {
+                // the wall generator checks the mirrored lines
+                lanes = 0;
+                for (int index : notesInBarBeat) {
+                    auto note = notes[index];
+                    // remove note
+                    if (note.colorType == (rotation > 0 ? ColorType::ColorA : ColorType::ColorB))
+                        target.result.removedNotes.emplace_back(index);
+                    else {
+                        // switch all notes to just one color
+                        if (note.colorType == (params.leftHanded ? ColorType::ColorB : ColorType::ColorA)) {
+                            Mirror(note, params.numberOfLines);
+                            target.Mirrored(index);
+                        }
+                    }
+                    if (note.lineIndex >= 0 && note.lineIndex < 4)
+                        lanes |= 1 << note.lineIndex;
+                }
+            }
+
+            // generate walls
+            if constexpr (WallGenerator) {
+                if (!state.containsCustomWalls) {
+                    ScopedTimer wallTimer(stats ? &stats->wallGenerationTime : nullptr);
+                    float wallTime = currentBarBeatStart;
+                    float wallDuration = dividedBarLength;
+
+                    // check if there already is a wall
+                    bool generateWall = !state.existingWalls->AnyOverlapping(wallTime, wallDuration);
+
+                    if (generateWall && afterLastNote != nullptr) {
+                        bool anyLine0 = lanes & 1;
+                        bool anyLine1 = lanes & 2;
+                        bool anyLine2 = lanes & 4;
+                        bool anyLine3 = lanes & 8;
+                        if (!anyLine0) {
+                            int wallHeight = anyLine1 ? 1 : 3;
+
+                            if (afterLastNote->lineIndex == 0 && !(wallHeight == 1 && afterLastNote->lineLayer == LineLayer::Base))
+                                wallDuration = afterLastNote->time - params.wallBackCut - wallTime;
+
+                            if (wallDuration > params.minWallDuration)
+                                target.result.generatedWalls.push_back({wallTime, wallDuration, 0, wallHeight == 1 ? LineLayer::Top : LineLayer::Base, 1, wallHeight});
+                        }
+                        if (!anyLine3) {
+                            int wallHeight = anyLine2 ? 1 : 3;
+
+                            if (afterLastNote->lineIndex == 3 && !(wallHeight == 1 && afterLastNote->lineLayer == LineLayer::Base))
+                                wallDuration = afterLastNote->time - params.wallBackCut - wallTime;
+
+                            if (wallDuration > params.minWallDuration)
+                                target.result.generatedWalls.push_back({wallTime, wallDuration, 3, wallHeight == 1 ? LineLayer::Top : LineLayer::Base, 1, wallHeight});
+                        }
+                    }
+                }
+            }
+
+            GENERATOR_TRACE(Verbose, "%.2f | Rotate %d (c=%lu, lc=%d, rc=%d, lastNotes=%d, rotationTime=%.2f, afterLastNote=%.2f, rotc=%d)",
+                currentBarBeatStart, rotation, notesInBarBeat.size(), leftCount, rightCount, segment.lastNotesCount, lastNoteTime + 0.01, afterLastNote ? afterLastNote->time : 0, rotationCount);
+        }
+
+        GENERATOR_TRACE(Debug, "%.2f (%.2f) -> %.2f(%.2f) | count=%d segments=%s barDiviver=%d",
+            currentBarStart + firstBeatmapNoteTime, (currentBarStart + firstBeatmapNoteTime) / beatDuration, currentBarEnd + firstBeatmapNoteTime, (currentBarEnd + firstBeatmapNoteTime) / beatDuration, bar.noteCount, segments, barDivider);
+    }
+
+    // bars in a chunk, the chunks only depend on the map so the work done doesn't depend on the thread count
+    static constexpr int ChunkBars = 32;
+
+    // if the carried states give the same decisions for the bars from the next one on
+    static bool SameCarried(Carried const& a, Carried const& b, float nextBarStart, float spinCooldown) {
+        if (a.totalRotation != b.totalRotation || a.previousDirection != b.previousDirection)
+            return false;
+        // a spin time only matters until its cooldown is over
+        return a.previousSpinTime == b.previousSpinTime || (nextBarStart - a.previousSpinTime > spinCooldown && nextBarStart - b.previousSpinTime > spinCooldown);
+    }
+
+    template<class List, class T>
+    static void AppendFrom(List& list, std::vector<T> const& from, int first) {
+        list.insert(list.end(), from.begin() + first, from.end());
+    }
+
+    // adds the edits of a chunk after a mark to the session
+    static void Append(SessionState& state, Chunk const& chunk, Chunk::Mark const& from) {
+        state.eventCount += chunk.eventCount - from.eventCount;
+        state.cutCount += chunk.cutCount - from.cutCount;
+        AppendFrom(state.result.rotations, chunk.result.rotations, from.rotations);
+        AppendFrom(state.leftCuts, chunk.leftCuts, from.leftCuts);
+        AppendFrom(state.rightCuts, chunk.rightCuts, from.rightCuts);
+        AppendFrom(state.result.removedNotes, chunk.result.removedNotes, from.removedNotes);
+        AppendFrom(state.result.generatedWalls, chunk.result.generatedWalls, from.generatedWalls);
+        for (int i = from.mirroredNotes; i < chunk.result.mirroredNotes.size(); i++)
+            state.Mirrored(chunk.result.mirroredNotes[i]);
+    }
+
+    // decides all the remaining bars, in chunks that are decided in parallel from the default carried state
+    // the real carried state at the start of each chunk is then followed through the bars in order, up to the first bar where the guess holds
+    // away from the limits only the previous direction has to match for that, which is usually the case after a few bars
+    // the bars before that are decided again in parallel, and everything is appended in order
+    // the edits are exactly the ones deciding the bars in order gives
+    template<bool EnableSpin, bool WallGenerator, bool OnlyOneSaber>
+    static void RunChunks(SessionState& state) {
+        auto& bars = state.analysis->bars;
+        int firstBar = state.nextBar;
+        int chunkCount = (bars.size() - firstBar + ChunkBars - 1) / ChunkBars;
+        if (chunkCount == 0)
+            return;
+
+        std::vector<Chunk> chunks(chunkCount);
+        std::vector<Chunk> redecided(chunkCount);
+        // for the chunks and the bars decided again, the trajectory isn't timed since it only repeats decisions
+        std::vector<Stats> chunkStats(state.stats ? 2 * chunkCount : 0);
+        for (int i = 0; i < chunkCount; i++) {
+            chunks[i].firstBar = firstBar + i * ChunkBars;
+            chunks[i].endBar = std::min<int>(chunks[i].firstBar + ChunkBars, bars.size());
+            if (state.stats) {
+                chunks[i].stats = &chunkStats[2 * i];
+                redecided[i].stats = &chunkStats[2 * i + 1];
+            }
+        }
+
+        // the first chunk goes straight into the session, it only mirrors notes in its own bars which the others don't read
+        state.pool->ParallelFor(chunkCount, [&state, &bars, &chunks](int i) {
+            auto& chunk = chunks[i];
+            if (i == 0) {
+                for (int bar = chunk.firstBar; bar < chunk.endBar; bar++)
+                    DecideBar<EnableSpin, WallGenerator, OnlyOneSaber>(state, state, bars[bar]);
+                return;
+            }
+            chunk.marks.reserve(chunk.endBar - chunk.firstBar);
+            for (int bar = chunk.firstBar; bar < chunk.endBar; bar++) {
+                DecideBar<EnableSpin, WallGenerator, OnlyOneSaber>(state, chunk, bars[bar]);
+                chunk.AddMark();
+            }
+        });
+
+        // where each chunk joins its guess, and the decisions before that from the real carried state
+        std::vector<int> joins(chunkCount);
+        std::vector<int> differences(chunkCount);
+        std::vector<std::pair<int, int>> ranges(ChunkBars + 1);
+        int redecidedBars = 0;
+        Trajectory trajectory{state.carried};
+        for (int i = 1; i < chunkCount; i++) {
+            auto& chunk = chunks[i];
+            int barCount = chunk.endBar - chunk.firstBar;
+            redecided[i].carried = trajectory.carried;
+
+            // the rotation differences all the decisions from a bar to the end of the chunk hold for
+            ranges[barCount] = {-Unbounded, Unbounded};
+            for (int j = barCount - 1; j >= 0; j--)
+                ranges[j] = {std::max(ranges[j + 1].first, chunk.marks[j].low), std::min(ranges[j + 1].second, chunk.marks[j].high)};
+
+            int bar = chunk.firstBar;
+            for (; bar < chunk.endBar; bar++) {
+                auto guessed = bar == chunk.firstBar ? Carried{} : chunk.marks[bar - chunk.firstBar - 1].carried;
+                auto range = ranges[bar - chunk.firstBar];
+                int difference = trajectory.carried.totalRotation - guessed.totalRotation;
+                guessed.totalRotation = trajectory.carried.totalRotation;
+                if (difference >= range.first && difference <= range.second && SameCarried(trajectory.carried, guessed, bars[bar].start, state.params.spinCooldown)) {
+                    differences[i] = difference;
+                    break;
+                }
+                DecideBar<EnableSpin, false, false>(state, trajectory, bars[bar]);
+            }
+            joins[i] = bar;
+            redecidedBars += bar - chunk.firstBar;
+            if (bar < chunk.endBar) {
+                trajectory.carried = chunk.carried;
+                trajectory.carried.totalRotation += differences[i];
+            }
+        }
+
+        state.pool->ParallelFor(chunkCount - 1, [&state, &bars, &chunks, &joins, &redecided](int i) {
+            for (int bar = chunks[i + 1].firstBar; bar < joins[i + 1]; bar++)
+                DecideBar<EnableSpin, WallGenerator, OnlyOneSaber>(state, redecided[i + 1], bars[bar]);
+        });
+
+        for (int i = 1; i < chunkCount; i++) {
+            auto& chunk = chunks[i];
+            Append(state, redecided[i], Chunk::Mark{});
+            if (joins[i] < chunk.endBar)
+                Append(state, chunk, joins[i] == chunk.firstBar ? Chunk::Mark{} : chunk.marks[joins[i] - chunk.firstBar - 1]);
+        }
+        state.carried = trajectory.carried;
+
+        state.nextBar = bars.size();
+        state.nextNote = bars.back().nextNote;
+        if (auto stats = state.stats) {
+            stats->redecidedBars += redecidedBars;
+            for (auto& chunk : chunkStats) {
+                stats->spinTime += chunk.spinTime;
+                stats->wallGenerationTime += chunk.wallGenerationTime;
+            }
+        }
+    }
+
+    template<bool EnableSpin, bool WallGenerator, bool OnlyOneSaber>
+    static void RunBars(SessionState& state, float time, std::chrono::steady_clock::time_point deadline) {
+        auto& notes = state.notes;
+        bool ownAnalysis = state.analysis == &state.ownAnalysis;
+        bool checkDeadline = deadline != std::chrono::steady_clock::time_point::max();
+
+        ScopedTimer barTimer(state.stats ? &state.stats->barTime : nullptr);
+
+        // all at once from a shared analysis, the pool can decide chunks of bars in parallel
+        if (state.pool && !ownAnalysis && !checkDeadline && std::isinf(time)) {
+            RunChunks<EnableSpin, WallGenerator, OnlyOneSaber>(state);
+            return;
+        }
+
+        // at least one bar is run each time, so generation always makes progress
+        int bars = 0;
+        while (state.nextNote < notes.size() && notes[state.nextNote].time <= time) {
+            if (checkDeadline && bars++ > 0 && std::chrono::steady_clock::now() > deadline)
+                break;
+
+            // only the bar being decided is kept
+            if (ownAnalysis) {
+                state.ownAnalysis.Clear();
+                state.nextBar = 0;
+                ExtractFeatures(state.ownAnalysis, notes, FindBar(state.ownAnalysis, notes), *state.barBuffers);
+            }
+            auto& bar = state.analysis->bars[state.nextBar++];
+            state.nextNote = bar.nextNote;
+            DecideBar<EnableSpin, WallGenerator, OnlyOneSaber>(state, state, bar);
+        }
+    }
+
+    // cuts the walls that no later cut can reach, in time order
+    void SessionState::CutWalls(float frontier) {
+        ScopedTimer timer(stats ? &stats->wallCutTime : nullptr);
+
+        // new cuts are merged in, keeping the order they were made in for equal times
+        auto byTime = [](Cut const& a, Cut const& b) { return a.time < b.time; };
+        for (auto [cuts, sorted] : {std::pair{&leftCuts, &sortedLeftCuts}, std::pair{&rightCuts, &sortedRightCuts}}) {
+            std::stable_sort(cuts->begin() + *sorted, cuts->end(), byTime);
+            std::inplace_merge(cuts->begin(), cuts->begin() + *sorted, cuts->end(), byTime);
+            *sorted = cuts->size();
+        }
+
+        // cut walls, walls will be cut when a rotation event is emitted
+        float wallFrontCut = params.wallFrontCut;
+        // rotations are at most 4 steps, with a second of leeway for the rounding of the pieces' end times
+        float maxBackCut = std::max(params.wallBackCut, params.wallBackCut * 4) + 1;
+
+        int kept = 0;
+        int next = 0;
+        // walls starting after the frontier can't be final yet
+        for (; next < pendingWalls.size() && walls[pendingWalls[next]].time < frontier; next++) {
+            int index = pendingWalls[next];
+            auto& wall = walls[index];
+            if (wall.duration <= 0)
+                continue;
+
+            // walls with this criteria are not fun in 360, remove it
+            if (wall.lineIndex == 1 || wall.lineIndex == 2 || (wall.lineIndex == 0 && wall.width > 1)) {
+                // only if there are any rotations at all
+                if (cutCount > 0)
+                    result.removedWalls.emplace_back(index);
+                else if (!BarsDone())
+                    pendingWalls[kept++] = index;
+                continue;
+            }
+
+            if (!(wall.time + wall.duration + maxBackCut < frontier)) {
+                pendingWalls[kept++] = index;
+                continue;
+            }
+
+            // first cut that can reach the wall
+            auto& cuts = wall.lineIndex <= 1 ? leftCuts : rightCuts;
+            auto first = std::partition_point(cuts.begin(), cuts.end(), [&wall, wallFrontCut](Cut const& cut) { return !(cut.time > wall.time - wallFrontCut); });
+
+            fragments.clear();
+            fragments.push_back({wall, false});
+            CutWall(fragments, std::span(first, cuts.end()), params);
+
+            if (fragments[0].removed)
+                result.removedWalls.emplace_back(index);
+            else if (fragments[0].wall.time != wall.time || fragments[0].wall.duration != wall.duration)
+                result.changedWalls.push_back({index, fragments[0].wall.time, fragments[0].wall.duration});
+            for (int i = 1; i < fragments.size(); i++) {
+                if (!fragments[i].removed)
+                    result.splitWalls.emplace_back(fragments[i].wall);
+            }
+        }
+        pendingWalls.erase(pendingWalls.begin() + kept, pendingWalls.begin() + next);
+    }
+
+    // removes bombs around cut walls that no later cut can reach, the bombs are already in time order
+    void SessionState::ClearBombs(float frontier) {
+        ScopedTimer timer(stats ? &stats->bombTime : nullptr);
+
+        for (; nextBomb < notes.size(); nextBomb++) {
+            auto& note = notes[nextBomb];
+            if (note.cutDirection != CutDirection::None)
+                continue;
+            if (!(note.time + params.wallFrontCut + 1 < frontier))
+                break;
+
+            if (note.lineIndex <= 2 && AnyCutNear(note.time, leftCuts, leftBombCursor, params))
+                result.removedNotes.emplace_back(nextBomb);
+            else if (note.lineIndex >= 1 && AnyCutNear(note.time, rightCuts, rightBombCursor, params))
+                result.removedNotes.emplace_back(nextBomb);
+        }
+    }
+
+    // indexed by enableSpin | wallGenerator << 1 | onlyOneSaber << 2
+    static constexpr decltype(SessionState::runBars) runBarsFunctions[] = {
+        RunBars<false, false, false>,
+        RunBars<true, false, false>,
+        RunBars<false, true, false>,
+        RunBars<true, true, false>,
+        RunBars<false, false, true>,
+        RunBars<true, false, true>,
+        RunBars<false, true, true>,
+        RunBars<true, true, true>,
+    };
+
+    // the most notes in any stretch of a bar length, no bar can have more, so the bar buffers are reserved once
+    static size_t MaxBarNotes(std::span<Note const> notes, float barLength) {
+        // a bit longer, bars are found with a tolerance
+        float window = barLength * 1.01f;
+        size_t maxNotes = 0;
+        for (size_t first = 0, last = 0; last < notes.size(); last++) {
+            while (notes[last].time - notes[first].time > window)
+                first++;
+            maxNotes = std::max(maxNotes, last - first + 1);
+        }
+        return maxNotes;
+    }
+
+    // most maps have a cut for every eighth note or fewer on each side, spin heavy ones grow into more blocks
+    static size_t CutsReserve(size_t notes) {
+        return notes / 8 + 16;
+    }
+
+    // the copies, the wall order and index, the bar buffers and the cut lists
+    static size_t ArenaSize(size_t notes, size_t walls, size_t maxBarNotes, Params const& params) {
+        size_t size = notes * sizeof(Note) + walls * (sizeof(Wall) + sizeof(int)) + 2 * CutsReserve(notes) * sizeof(Cut) + 1024;
+        size += maxBarNotes * (sizeof(int) * 3 + sizeof(uint8_t)) + sizeof(Bar) + 8 * sizeof(Segment);
+        size += FragmentsReserve * sizeof(Fragment);
+        if (params.wallGenerator)
+            size += walls * sizeof(float) * 2;
+        return size;
+    }
+
+    static void ReserveBarBuffers(Analysis& analysis, size_t maxBarNotes, size_t bars, size_t segments) {
+        analysis.bars.reserve(bars);
+        analysis.segments.reserve(segments);
+        analysis.barNotes.reserve(maxBarNotes);
+        analysis.barTicks.reserve(maxBarNotes);
+    }
+
+    // without a shared analysis, the session analyzes its own bars as it goes
+    static std::unique_ptr<SessionState> CreateState(std::span<Note const> notes, std::span<Wall const> walls, Params const& params, Stats* stats, Analysis const* sharedAnalysis) {
+        float barLength = sharedAnalysis ? sharedAnalysis->barLength : BarLength(params);
+        size_t maxBarNotes = sharedAnalysis ? 0 : MaxBarNotes(notes, barLength);
+
+        auto state = std::make_unique<SessionState>(ArenaSize(notes.size(), walls.size(), maxBarNotes, params));
+        state->params = params;
+        state->stats = stats;
+        state->notes.assign(notes.begin(), notes.end());
+        state->walls.assign(walls.begin(), walls.end());
+        state->runBars = runBarsFunctions[params.enableSpin | params.wallGenerator << 1 | params.onlyOneSaber << 2];
+
+        auto& analysis = state->ownAnalysis;
+        analysis.SetTiming(60 / params.bpm, barLength, notes.empty() ? 0 : notes[0].time);
+        if (sharedAnalysis)
+            state->analysis = sharedAnalysis;
+        else {
+            ReserveBarBuffers(analysis, maxBarNotes, 1, 8);
+            state->barBuffers.emplace(state->arena, maxBarNotes);
+        }
+
+        state->beatDuration = state->analysis->beatDuration;
+        state->barLength = state->analysis->barLength;
+        state->firstBeatmapNoteTime = state->analysis->firstBeatmapNoteTime;
+
+        // nothing to do without notes
+        if (notes.empty())
+            return state;
+
+        state->fragments.reserve(FragmentsReserve);
+        state->leftCuts.reserve(CutsReserve(notes.size()));
+        state->rightCuts.reserve(CutsReserve(notes.size()));
+
+        state->pendingWalls.resize(walls.size());
+        std::iota(state->pendingWalls.begin(), state->pendingWalls.end(), 0);
+        std::stable_sort(state->pendingWalls.begin(), state->pendingWalls.end(), [&walls](int a, int b) { return walls[a].time < walls[b].time; });
+
+        if (params.wallGenerator)
+            state->existingWalls.emplace(walls, state->pendingWalls, state->arena);
+
+        GENERATOR_TRACE(Info, "Setup bpm=%.2f beatDuration=%.2f barLength=%.2f firstNoteTime=%.2f", params.bpm, state->beatDuration, state->barLength, state->firstBeatmapNoteTime);
+        return state;
+    }
+
+    static bool IsDone(SessionState const& state) {
+        return state.BarsDone() && state.pendingWalls.empty() && state.nextBomb >= state.notes.size();
+    }
+
+    static bool Advance(SessionState& state, float time, std::chrono::steady_clock::time_point deadline) {
+        if (IsDone(state))
+            return true;
+
+        state.runBars(state, time, deadline);
+
+        float frontier = state.CutFrontier();
+        state.CutWalls(frontier);
+        state.ClearBombs(frontier);
+
+        if (IsDone(state)) {
+            GENERATOR_TRACE(Info, "Emitted %d rotation events", state.eventCount);
+
+            if (auto stats = state.stats) {
+                stats->notes = state.notes.size();
+                stats->walls = state.walls.size();
+                stats->cuts = state.cutCount;
+                stats->splitWalls = state.result.splitWalls.size();
+                stats->removedNotes = state.result.removedNotes.size();
+                stats->removedWalls = state.result.removedWalls.size();
+                stats->arenaBytes = state.arena.GetUsedBytes();
+                stats->arenaCapacity = state.arena.GetCapacity();
+            }
+        }
+        return IsDone(state);
+    }
+
+    // one bar at a time, so it stops as soon as the objects are final
+    static bool Finalize(SessionState& state, float time) {
+        while (!IsDone(state) && !(state.CompletedTime() > time))
+            Advance(state, state.BarsDone() ? INFINITY : state.notes[state.nextNote].time, std::chrono::steady_clock::time_point::max());
+        return IsDone(state);
+    }
+
+    Session::Session(std::span<Note const> notes, std::span<Wall const> walls, Params const& params, Stats* stats)
+        : state(CreateState(notes, walls, params, stats, nullptr)) {}
+
+    Session::~Session() = default;
+
+    bool Session::Advance(float time, std::chrono::steady_clock::time_point deadline) {
+        return Generator::Advance(*state, time, deadline);
+    }
+
+    bool Session::Finalize(float time) {
+        return Generator::Finalize(*state, time);
+    }
+
+    bool Session::IsDone() const {
+        return Generator::IsDone(*state);
+    }
+
+    float Session::GetCompletedTime() const {
+        if (IsDone())
+            return INFINITY;
+        return state->CompletedTime();
+    }
+
+    // the items of a list that were added since the last call
+    template<class T>
+    static std::vector<T> TakeNew(std::vector<T> const& list, int& taken) {
+        std::vector<T> ret(list.begin() + taken, list.end());
+        taken = list.size();
+        return ret;
+    }
+
+    Result Session::TakeCompleted() {
+        auto& result = state->result;
+        Result completed{};
+        completed.rotations = TakeNew(result.rotations, state->takenRotations);
+        completed.removedNotes = TakeNew(result.removedNotes, state->takenRemovedNotes);
+        completed.mirroredNotes = TakeNew(result.mirroredNotes, state->takenMirroredNotes);
+        completed.removedWalls = TakeNew(result.removedWalls, state->takenRemovedWalls);
+        completed.changedWalls = TakeNew(result.changedWalls, state->takenChangedWalls);
+        completed.generatedWalls = TakeNew(result.generatedWalls, state->takenGeneratedWalls);
+        completed.splitWalls = TakeNew(result.splitWalls, state->takenSplitWalls);
+        return completed;
+    }
+
+    static Result TakeResult(SessionState& state) {
+        auto result = std::move(state.result);
+        state.result = {};
+        std::sort(result.removedNotes.begin(), result.removedNotes.end());
+        std::sort(result.removedWalls.begin(), result.removedWalls.end());
+        std::sort(result.changedWalls.begin(), result.changedWalls.end(), [](auto& a, auto& b) { return a.index < b.index; });
+        return result;
+    }
+
+    Result Session::TakeResult() {
+        return Generator::TakeResult(*state);
+    }
+
+    Result Generate(std::span<Note const> notes, std::span<Wall const> walls, Params const& params, Stats* stats, ThreadPool* pool) {
+        // the whole analysis up front only pays off when it can be spread over threads
+        if (pool)
+            return std::move(GenerateVariants(notes, walls, std::span(&params, 1), stats, pool)[0]);
+
+        Session session(notes, walls, params, stats);
+        session.Advance(INFINITY);
+        return session.TakeResult();
+    }
+
+    std::vector<Result> GenerateVariants(std::span<Note const> notes, std::span<Wall const> walls, std::span<Params const> variants, Stats* stats, ThreadPool* pool) {
+        std::vector<Result> results{};
+        if (variants.empty())
+            return results;
+
+        // all the bars are analyzed once, before any rotations are decided
+        auto& params = variants[0];
+        float barLength = BarLength(params);
+        size_t maxBarNotes = MaxBarNotes(notes, barLength);
+        Arena arena(notes.size() * (sizeof(int) * 2 + sizeof(Segment) / 2) + 1024);
+        Analysis analysis(arena);
+        analysis.SetTiming(60 / params.bpm, barLength, notes.empty() ? 0 : notes[0].time);
+        {
+            ScopedTimer timer(stats ? &stats[0].barTime : nullptr);
+            if (!notes.empty()) {
+                ReserveBarBuffers(analysis, maxBarNotes, notes.size() / 8 + 16, notes.size() / 2 + 16);
+            }
+            AnalyzeAll(analysis, notes, maxBarNotes, pool);
+        }
+
+        for (int i = 0; i < variants.size(); i++) {
+            auto state = CreateState(notes, walls, variants[i], stats ? &stats[i] : nullptr, &analysis);
+            state->pool = pool;
+            Generator::Advance(*state, INFINITY, std::chrono::steady_clock::time_point::max());
+            results.push_back(TakeResult(*state));
+        }
+        return results;
+    }
+}
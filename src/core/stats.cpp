@@ -0,0 +1,70 @@
+#include "core/stats.hpp"
+
+#include <cstdio>
+
+namespace Generator {
+    std::string FormatStats(Stats const& stats) {
+        char buffer[384];
+        snprintf(buffer, sizeof(buffer),
+            "notes=%d walls=%d cuts=%d splits=%d removedNotes=%d removedWalls=%d arena=%.1f/%.1fKB | "
+            "copy=%.2f extract=%.2f bars=%.2f (spin=%.2f walls=%.2f) cut=%.2f bombs=%.2f remove=%.2f insert=%.2f total=%.2fms",
+            stats.notes, stats.walls, stats.cuts, stats.splitWalls, stats.removedNotes, stats.removedWalls, stats.arenaBytes / 1024.0, stats.arenaCapacity / 1024.0,
+            stats.copyTime, stats.extractTime, stats.barTime, stats.spinTime, stats.wallGenerationTime, stats.wallCutTime, stats.bombTime, stats.removeTime, stats.insertTime, stats.TotalTime());
+        return buffer;
+    }
+
+    void StatsHistory::Add(Stats const& stats) {
+        entries[next] = stats;
+        next = (next + 1) % Size;
+        if (count < Size)
+            count++;
+    }
+
+    Stats StatsHistory::Average() const {
+        Stats average{};
+        if (count == 0)
+            return average;
+
+        for (int i = 0; i < count; i++) {
+            auto& entry = entries[i];
+            average.copyTime += entry.copyTime;
+            average.extractTime += entry.extractTime;
+            average.removeTime += entry.removeTime;
+            average.insertTime += entry.insertTime;
+            average.barTime += entry.barTime;
+            average.spinTime += entry.spinTime;
+            average.wallGenerationTime += entry.wallGenerationTime;
+            average.wallCutTime += entry.wallCutTime;
+            average.bombTime += entry.bombTime;
+            average.notes += entry.notes;
+            average.walls += entry.walls;
+            average.cuts += entry.cuts;
+            average.splitWalls += entry.splitWalls;
+            average.removedNotes += entry.removedNotes;
+            average.removedWalls += entry.removedWalls;
+            average.redecidedBars += entry.redecidedBars;
+            average.arenaBytes += entry.arenaBytes;
+            average.arenaCapacity += entry.arenaCapacity;
+        }
+
+        average.copyTime /= count;
+        average.extractTime /= count;
+        average.removeTime /= count;
+        average.insertTime /= count;
+        average.barTime /= count;
+        average.spinTime /= count;
+        average.wallGenerationTime /= count;
+        average.wallCutTime /= count;
+        average.bombTime /= count;
+        average.notes /= count;
+        average.walls /= count;
+        average.cuts /= count;
+        average.splitWalls /= count;
+        average.removedNotes /= count;
+        average.removedWalls /= count;
+        average.redecidedBars /= count;
+        average.arenaBytes /= count;
+        average.arenaCapacity /= count;
+        return average;
+    }
+}
@@ -0,0 +1,140 @@
+#include "core/threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Generator {
+    // the pool and queue of the current thread, if it is a worker
+    static thread_local ThreadPool* currentPool = nullptr;
+    static thread_local int currentWorker = -1;
+
+    ThreadPool::ThreadPool(int threads) {
+        if (threads <= 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (int i = 0; i < threads; i++)
+            queues.push_back(std::make_unique<Queue>());
+        for (int i = 0; i < threads; i++)
+            workers.emplace_back([this, i]() { Work(i); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        Wait();
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    void ThreadPool::Submit(std::function<void()> job) {
+        int queue;
+        {
+            // counted before the job can be taken, so pending never drops to 0 early
+            std::lock_guard lock(mutex);
+            queue = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+            queued++;
+            pending++;
+        }
+        {
+            std::lock_guard lock(queues[queue]->mutex);
+            // newest first on the own queue, the jobs it submitted are likely to use the same data
+            if (currentPool == this)
+                queues[queue]->jobs.push_front(std::move(job));
+            else
+                queues[queue]->jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    void ThreadPool::Wait() {
+        std::unique_lock lock(mutex);
+        done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    void ThreadPool::ParallelFor(int count, std::function<void(int)> body) {
+        // shared with the helper jobs, which can start after everything is done and then find no index left
+        struct Loop {
+            std::function<void(int)> body;
+            int count;
+            std::atomic<int> next = 0;
+            std::atomic<int> done = 0;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto loop = std::make_shared<Loop>();
+        loop->body = std::move(body);
+        loop->count = count;
+
+        auto Run = [](Loop& loop) {
+            int ran = 0;
+            for (int i; (i = loop.next++) < loop.count; ran++)
+                loop.body(i);
+            if (ran > 0 && (loop.done += ran) == loop.count) {
+                std::lock_guard lock(loop.mutex);
+                loop.finished.notify_all();
+            }
+        };
+
+        int helpers = std::min(count - 1, GetThreadCount());
+        for (int i = 0; i < helpers; i++)
+            Submit([loop, Run]() { Run(*loop); });
+        Run(*loop);
+
+        // only indices that a helper is still running are left
+        std::unique_lock lock(loop->mutex);
+        loop->finished.wait(lock, [&loop]() { return loop->done == loop->count; });
+    }
+
+    bool ThreadPool::TakeJob(int worker, std::function<void()>& job) {
+        bool found = false;
+        {
+            auto& own = *queues[worker];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = std::move(own.jobs.front());
+                own.jobs.pop_front();
+                found = true;
+            }
+        }
+        for (int i = 1; !found && i < queues.size(); i++) {
+            auto& other = *queues[(worker + i) % queues.size()];
+            std::lock_guard lock(other.mutex);
+            if (!other.jobs.empty()) {
+                job = std::move(other.jobs.back());
+                other.jobs.pop_back();
+                found = true;
+            }
+        }
+        if (found) {
+            std::lock_guard lock(mutex);
+            queued--;
+        }
+        return found;
+    }
+
+    void ThreadPool::Work(int worker) {
+        currentPool = this;
+        currentWorker = worker;
+
+        std::function<void()> job;
+        while (true) {
+            if (TakeJob(worker, job)) {
+                job();
+                job = nullptr;
+
+                std::lock_guard lock(mutex);
+                if (--pending == 0)
+                    done.notify_all();
+                continue;
+            }
+            std::unique_lock lock(mutex);
+            // queued is ahead of the queues while a job is being submitted or taken, then this just tries again
+            wake.wait(lock, [this]() { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#include "core/trace.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+
+namespace Generator {
+    static void (*logFunction)(char const* message) = nullptr;
+
+    // allocated once, a message overwrites the oldest one when full
+    static char traceBuffer[TraceBufferCount][TraceMessageSize];
+    static int traceStart = 0;
+    static int traceCount = 0;
+    // generation can run on the main thread and pregeneration workers at the same time
+    static std::mutex traceMutex;
+
+    void SetLogFunction(void (*function)(char const* message)) {
+        logFunction = function;
+    }
+
+    void Trace(TraceLevel level, char const* format, ...) {
+        std::unique_lock lock(traceMutex);
+
+        int index = (traceStart + traceCount) % TraceBufferCount;
+        if (traceCount < TraceBufferCount)
+            traceCount++;
+        else
+            traceStart = (traceStart + 1) % TraceBufferCount;
+
+        auto message = traceBuffer[index];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(message, TraceMessageSize, format, args);
+        va_end(args);
+
+        if (level <= TraceLevel::Info && logFunction)
+            logFunction(message);
+    }
+
+    void DumpTrace() {
+        std::unique_lock lock(traceMutex);
+
+        if (logFunction) {
+            for (int i = 0; i < traceCount; i++)
+                logFunction(traceBuffer[(traceStart + i) % TraceBufferCount]);
+        }
+        traceStart = 0;
+        traceCount = 0;
+    }
+
+    void ClearTrace() {
+        std::unique_lock lock(traceMutex);
+
+        traceStart = 0;
+        traceCount = 0;
+    }
+}
@@ -3,6 +3,8 @@
 #include "main.hpp"
 #include "config.hpp"
 #include "generator.hpp"
+#include "pregen.hpp"
+#include "stream.hpp"
 
 #define CHECK_VAL(name) if (getConfig().name.GetValue() != getConfig().name.GetDefaultValue()) return false;
 
@@ -28,429 +30,438 @@ bool SettingsAreDefault(bool for90Degree) {
     return true;
 }
 
+#include "core/hash.hpp"
+
+#define HASH_VAL(name) hasher.Add(getConfig().name.GetValue());
+
+uint64_t SettingsHash() {
+    Generator::Hasher hasher{};
+    HASH_VAL(BasedOn);
+    HASH_VAL(PreferredBarDuration);
+    HASH_VAL(LimitRotations360);
+    HASH_VAL(BottleneckRotations360);
+    HASH_VAL(LimitRotations90);
+    HASH_VAL(BottleneckRotations90);
+    HASH_VAL(EnableSpin);
+    HASH_VAL(TotalSpinTime);
+    HASH_VAL(SpinCooldown);
+    HASH_VAL(WallFrontCut);
+    HASH_VAL(WallBackCut);
+    HASH_VAL(MinWallDuration);
+    HASH_VAL(WallGenerator);
+    HASH_VAL(OnlyOneSaber);
+    return hasher.Get();
+}
+
+#include "core/generator.hpp"
+#include "core/cache.hpp"
+#include "core/diskcache.hpp"
+#include "core/stats.hpp"
+#include "core/trace.hpp"
+
+#include "beatsaber-hook/shared/utils/utils.h"
+
 #include "GlobalNamespace/NoteData.hpp"
 #include "GlobalNamespace/NoteCutDirection.hpp"
 
 #include "GlobalNamespace/BeatmapData.hpp"
+#include "GlobalNamespace/BeatmapDataItem.hpp"
+#include "GlobalNamespace/BeatmapObjectData.hpp"
+#include "GlobalNamespace/BeatmapEventData.hpp"
 #include "GlobalNamespace/SpawnRotationBeatmapEventData.hpp"
 #include "System/Collections/Generic/LinkedList_1.hpp"
+#include "System/Collections/Generic/LinkedListNode_1.hpp"
+#include "System/Collections/Generic/IEnumerable_1.hpp"
+#include "System/Collections/Generic/IEnumerator_1.hpp"
+#include "System/Collections/IEnumerator.hpp"
 #include "GlobalNamespace/ObstacleData.hpp"
 #include "GlobalNamespace/ColorType.hpp"
 #include "GlobalNamespace/NoteLineLayer.hpp"
 
-#include <queue>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace GlobalNamespace;
 
-int SoftFloor(float f) {
-    int i = (int)f;
-    return f - i >= 0.999 ? i + 1 : i;
+Generator::Params GetParams(float bpm, bool is90Degree, bool leftHanded, int numberOfLines) {
+    Generator::Params params{};
+    params.bpm = bpm;
+    params.leftHanded = leftHanded;
+    params.numberOfLines = numberOfLines;
+    params.preferredBarDuration = getConfig().PreferredBarDuration.GetValue();
+    params.rotationLimit = is90Degree ? getConfig().LimitRotations90.GetValue() : getConfig().LimitRotations360.GetValue();
+    params.bottleneckRotations = is90Degree ? getConfig().BottleneckRotations90.GetValue() : getConfig().BottleneckRotations360.GetValue();
+    params.enableSpin = getConfig().EnableSpin.GetValue();
+    params.totalSpinTime = getConfig().TotalSpinTime.GetValue();
+    params.spinCooldown = getConfig().SpinCooldown.GetValue();
+    params.wallFrontCut = getConfig().WallFrontCut.GetValue();
+    params.wallBackCut = getConfig().WallBackCut.GetValue();
+    params.minWallDuration = getConfig().MinWallDuration.GetValue();
+    params.wallGenerator = getConfig().WallGenerator.GetValue();
+    params.onlyOneSaber = getConfig().OnlyOneSaber.GetValue();
+    return params;
 }
 
-std::pair<int, int> LeftAndRightCounts(std::vector<NoteData*> notes) {
-    int leftCount = 0;
-    int rightCount = 0;
+Generator::CacheKey GetCacheKey(std::string const& levelId, int difficulty, bool is90Degree, bool leftHanded) {
+    return {levelId, difficulty, getConfig().BasedOn.GetValue(), is90Degree, leftHanded, SettingsHash()};
+}
 
-    for (auto& note : notes) {
-        auto dir = note->cutDirection;
-        if (dir == NoteCutDirection::Left || dir == NoteCutDirection::UpLeft || dir == NoteCutDirection::DownLeft)
-            leftCount++;
-        else if (dir == NoteCutDirection::Right || dir == NoteCutDirection::UpRight || dir == NoteCutDirection::DownRight)
-            rightCount++;
+enum class ItemType {
+    Other,
+    Note,
+    Wall,
+};
+
+// classifies each class once, including subclasses like the ones from custom json data
+// per thread since pregeneration extracts on worker threads, there are only a handful of item classes
+static ItemType GetItemType(Il2CppClass* klass) {
+    thread_local std::vector<std::pair<Il2CppClass*, ItemType>> types{};
+    for (auto& [known, type] : types) {
+        if (known == klass)
+            return type;
     }
-    return { leftCount, rightCount };
+    auto type = ItemType::Other;
+    if (il2cpp_functions::class_is_assignable_from(classof(NoteData*), klass))
+        type = ItemType::Note;
+    else if (il2cpp_functions::class_is_assignable_from(classof(ObstacleData*), klass))
+        type = ItemType::Wall;
+    types.emplace_back(klass, type);
+    return type;
 }
 
-IReadonlyBeatmapData* Generate(IReadonlyBeatmapData* base, float bpm, bool is90Degree, bool leftHanded) {
-    auto data = base->GetCopy();
+void ExtractItems(IReadonlyBeatmapData* data, std::vector<Generator::Note>& notes, std::vector<Generator::Wall>& walls, std::vector<NoteData*>* noteObjects, std::vector<ObstacleData*>* wallObjects, ItemNodes* nodes) {
     auto items = data->get_allBeatmapDataItems();
-
-    // TODO
-    bool containsCustomWalls = false;
-
-    // amount of rotation events emitted
-    int eventCount = 0;
-    // current rotation
-    int totalRotation = 0;
-    // moments where a wall should be cut
-    std::vector<std::pair<float, int>> wallCutMoments{};
-    // previous spin direction, false is left, true is right
-    bool previousDirection = true;
-    float previousSpinTime = -1;
-
-    int rotLimit = is90Degree ? getConfig().LimitRotations90.GetValue() : getConfig().LimitRotations360.GetValue();
-
-    auto Rotate = [&](float time, int amount, SpawnRotationBeatmapEventData::SpawnRotationEventType moment, bool enableLimit = true) {
-        if (amount == 0)
-            return;
-        if (amount < -4)
-            amount = -4;
-        if (amount > 4)
-            amount = 4;
-
-        if (enableLimit) {
-            if (totalRotation + amount > rotLimit)
-                amount = std::min(amount, std::max(0, rotLimit - totalRotation));
-            else if (totalRotation + amount < -rotLimit)
-                amount = std::max(amount, std::min(0, -(rotLimit + totalRotation)));
-            if (amount == 0)
-                return;
-
-            totalRotation += amount;
+    // most items are notes, walls are much fewer
+    notes.reserve(items->get_Count());
+    if (noteObjects)
+        noteObjects->reserve(items->get_Count());
+
+    // walk the nodes directly and check the class of each item once, instead of an enumerator and two casts per item
+    for (auto node = items->get_First(); node; node = node->get_Next()) {
+        auto item = node->get_Value();
+        switch (GetItemType(reinterpret_cast<Il2CppObject*>(item)->klass)) {
+            case ItemType::Note: {
+                auto note = reinterpret_cast<NoteData*>(item);
+                if (noteObjects)
+                    noteObjects->emplace_back(note);
+                if (nodes)
+                    nodes->notes.emplace_back(node);
+                notes.push_back({note->time, note->lineIndex, (Generator::LineLayer) note->noteLineLayer.value, (Generator::ColorType) note->colorType.value, (Generator::CutDirection) note->cutDirection.value});
+                break;
+            }
+            case ItemType::Wall: {
+                auto wall = reinterpret_cast<ObstacleData*>(item);
+                if (wallObjects)
+                    wallObjects->emplace_back(wall);
+                if (nodes)
+                    nodes->walls.emplace_back(node);
+                walls.push_back({wall->time, wall->duration, wall->lineIndex, (Generator::LineLayer) wall->lineLayer.value, wall->width, wall->height});
+                break;
+            }
+            default:
+                break;
         }
-
-        previousDirection = amount > 0;
-        eventCount++;
-        wallCutMoments.emplace_back(time, amount);
-
-        data->InsertBeatmapEventDataInOrder(SpawnRotationBeatmapEventData::New_ctor(time, moment, amount * 15));
-    };
-
-    float beatDuration = 60 / bpm;
-    float preferredDuration = getConfig().PreferredBarDuration.GetValue();
-
-    // align beat duration to between 75% and 150% of preferred
-    float barLength = beatDuration;
-    while (barLength >= preferredDuration * 1.5)
-        barLength /= 2;
-    while (barLength < preferredDuration * 0.75)
-        barLength *= 2;
-
-    // filter the beatmap data to find all notes and walls (walls are used later)
-    std::vector<NoteData*> notes{};
-    std::vector<ObstacleData*> walls{};
-    auto enumerator = items->GetEnumerator();
-    while (enumerator.MoveNext()) {
-        if (auto note = il2cpp_utils::try_cast<NoteData>(enumerator.current))
-            notes.emplace_back(*note);
-        if (auto wall = il2cpp_utils::try_cast<ObstacleData>(enumerator.current))
-            walls.emplace_back(*wall);
     }
-    std::vector<NoteData*> notesInBar{};
-    std::vector<NoteData*> notesInBarBeat{};
-
-    // align bars to first note, the first note (almost always) identifies the start of the first bar
-    float firstBeatmapNoteTime = notes[0]->time;
-
-    getLogger().info("Setup bpm=%.2f beatDuration=%.2f barLength=%.2f firstNoteTime=%.2f", bpm, beatDuration, barLength, firstBeatmapNoteTime);
+}
 
-    for (int i = 0; i < notes.size(); ) {
-        // find the start and end of the current bar, discarding offset by using the first note
-        float currentBarStart = SoftFloor((notes[i]->time - firstBeatmapNoteTime) / barLength) * barLength;
-        float currentBarEnd = currentBarStart + barLength - 0.001;
+ObstacleData* CreateObstacle(Generator::Wall const& wall) {
+    return ObstacleData::New_ctor(wall.time, wall.lineIndex, NoteLineLayer((int) wall.lineLayer), wall.duration, wall.width, wall.height);
+}
 
-        // get all the non bomb notes in the current bar
-        notesInBar.clear();
-        for (; i < notes.size() && notes[i]->time - firstBeatmapNoteTime < currentBarEnd; i++) {
-            // not bomb
-            if (notes[i]->cutDirection != NoteCutDirection::None)
-                notesInBar.emplace_back(notes[i]);
+// removes all the items in one pass over the list, instead of searching the list for each of them
+int RemoveItems(System::Collections::Generic::LinkedList_1<BeatmapDataItem*>* items, std::unordered_set<BeatmapDataItem*> const& removed) {
+    int count = 0;
+    auto node = items->get_First();
+    while (node && count < removed.size()) {
+        auto next = node->get_Next();
+        if (removed.contains(node->get_Value())) {
+            items->Remove(node);
+            count++;
         }
+        node = next;
+    }
+    return count;
+}
 
-        // no rotations if no notes
-        if (notesInBar.size() == 0)
-            continue;
+// the objects of a type in the beatmap, as the lists by type show them to the game
+template<class T>
+static std::unordered_set<BeatmapDataItem*> GetTypeView(BeatmapData* data) {
+    std::unordered_set<BeatmapDataItem*> view{};
+    auto enumerator = data->GetBeatmapDataItems<T*>(0)->GetEnumerator();
+    while (enumerator->i_IEnumerator()->MoveNext())
+        view.emplace(enumerator->get_Current());
+    return view;
+}
 
-        // find if all the notes are basically at the same time, to determine if we do a spin
-        bool allSameTime = true;
-        for (auto& note : notesInBar) {
-            if (abs(note->time - notesInBar[0]->time) >= 0.001)
-                allSameTime = false;
-        }
+// the edited objects must be the instances both the list of all items and the lists by type hold
+// otherwise some of the game sees the edits and some doesn't, only checked when debug tracing
+static void CheckEditedInstances(BeatmapData* data, Generator::Result const& result, std::vector<NoteData*> const& noteObjects, std::vector<ObstacleData*> const& wallObjects) {
+    std::unordered_set<BeatmapDataItem*> all{};
+    auto items = data->get_allBeatmapDataItems();
+    for (auto node = items->get_First(); node; node = node->get_Next())
+        all.emplace(node->get_Value());
+
+    auto notes = GetTypeView<NoteData>(data);
+    int missing = 0;
+    for (auto& index : result.mirroredNotes)
+        missing += !all.contains(noteObjects[index]) || !notes.contains(noteObjects[index]);
+    auto walls = GetTypeView<ObstacleData>(data);
+    for (auto& change : result.changedWalls)
+        missing += !all.contains(wallObjects[change.index]) || !walls.contains(wallObjects[change.index]);
+
+    if (missing > 0)
+        getLogger().error("%d edited objects are not the ones the beatmap lists hold", missing);
+    else
+        GENERATOR_TRACE(Debug, "Edited objects are the same instances in all beatmap lists");
+}
 
-        // spin around if there are 2+ notes at the same time, respecting the cooldown
-        if (getConfig().EnableSpin.GetValue() && notesInBar.size() >= 2 && currentBarStart - previousSpinTime > getConfig().SpinCooldown.GetValue() && allSameTime) {
-            getLogger().info("Generator | Spin effect at %.2f", firstBeatmapNoteTime + currentBarStart);
-
-            auto [leftCount, rightCount] = LeftAndRightCounts(notesInBar);
-
-            // determine the spin direction based on which way the notes are pointing
-            // continuing the last direction if they are equal
-            int spinDirection;
-            if (leftCount == rightCount)
-                spinDirection = previousDirection ? -1 : 1;
-            else if (leftCount > rightCount)
-                spinDirection = -1;
-            else
-                spinDirection = 1;
-
-            float spinStep = getConfig().TotalSpinTime.GetValue() / 24;
-            for (int s = 0; s < 24; s++)
-                Rotate(firstBeatmapNoteTime + currentBarStart + spinStep * s, spinDirection, SpawnRotationBeatmapEventData::SpawnRotationEventType::Early, false);
-
-            // do not emit more rotation events after this
-            previousSpinTime = currentBarStart;
-            continue;
+// inserts the items, which must be sorted by time, into the list of all items in one pass
+// each item goes after the ones already at its time, like the in order methods of BeatmapData
+// those still add each item to its list by type and keep the event bookkeeping, they only leave the list of all items to the merge
+// the lists by type are short and searched from their end, so the time sorted items are added close to where the search starts
+// the search starts from the last inserted node, or the start of the list without one, and walks back first if the item is before it
+void InsertItems(BeatmapData* data, std::vector<std::pair<float, BeatmapDataItem*>> const& inserted, ItemNode*& lastInserted) {
+    auto items = data->get_allBeatmapDataItems();
+    data->set_updateAllBeatmapDataOnInsert(false);
+    for (auto& [time, item] : inserted) {
+        // only walls and rotation events are inserted
+        if (GetItemType(reinterpret_cast<Il2CppObject*>(item)->klass) == ItemType::Wall)
+            data->AddBeatmapObjectDataInOrder(reinterpret_cast<BeatmapObjectData*>(item));
+        else
+            data->InsertBeatmapEventDataInOrder(reinterpret_cast<BeatmapEventData*>(item));
+
+        // the first node after the time
+        ItemNode* node = items->get_First();
+        if (lastInserted && lastInserted->get_Value()->time <= time)
+            node = lastInserted->get_Next();
+        else if (lastInserted) {
+            node = lastInserted;
+            for (auto previous = node->get_Previous(); previous && previous->get_Value()->time > time; previous = node->get_Previous())
+                node = previous;
         }
+        while (node && node->get_Value()->time <= time)
+            node = node->get_Next();
+        lastInserted = node ? items->AddBefore(node, item) : items->AddLast(item);
+    }
+    data->set_updateAllBeatmapDataOnInsert(true);
+}
 
-        // divide the current bar in x pieces (or notes), for each piece, a rotation event CAN be emitted
-        // calculated from the amount of notes in the current bar
-        // barDivider | rotations
-        // 0          | . . . . (no rotations)
-        // 1          | r . . . (only on first beat)
-        // 2          | r . r . (on first and third beat)
-        // 4          | r r r r
-        // 8          | rrrrrrrr
-        // ...        | ...
-        // TODO: create formula out of these if statements
-        int barDivider;
-        if (notesInBar.size() >= 58)
-            barDivider = 0; // too many notes, do not rotate
-        else if (notesInBar.size() >= 38)
-            barDivider = 1;
-        else if (notesInBar.size() >= 26)
-            barDivider = 2;
-        else if (notesInBar.size() >= 8)
-            barDivider = 4;
-        else
-            barDivider = 8;
+Generator::ResultCache& GetResultCache() {
+    static Generator::ResultCache cache(0);
+    return cache;
+}
+
+Generator::DiskCache& GetDiskCache() {
+    static Generator::DiskCache cache(getDataDir(getModInfo()) + "cache", 0);
+    return cache;
+}
 
-        if (barDivider <= 0)
-            continue;
+void ApplyResult(BeatmapData* data, Generator::Result const& result, std::vector<NoteData*> const& noteObjects, std::vector<ObstacleData*> const& wallObjects, Generator::Stats* stats, ItemNodes* nodes) {
+    auto items = data->get_allBeatmapDataItems();
 
-        std::stringstream debugStream;
+    for (auto& index : result.mirroredNotes)
+        noteObjects[index]->Mirror(data->numberOfLines);
 
-        // iterate all the notes in the current bar in barDiviver pieces (bar is split in barDiviver pieces)
-        float dividedBarLength = barLength / barDivider;
-        for (int j = 0, k = 0; j < barDivider && k < notesInBar.size(); j++) {
-            // find all the notes in the current division of the bar
-            notesInBarBeat.clear();
-            for (; k < notesInBar.size() && SoftFloor((notesInBar[k]->time - firstBeatmapNoteTime - currentBarStart) / dividedBarLength) == j; k++)
-                notesInBarBeat.emplace_back(notesInBar[k]);
+    // objects to remove, by their nodes if known, otherwise in a set so they can all be removed in one pass
+    std::unordered_set<BeatmapDataItem*> removedItems{};
+    std::vector<ItemNode*> removedNodes{};
+    for (auto& index : result.removedNotes) {
+        if (nodes)
+            removedNodes.emplace_back(nodes->notes[index]);
+        else
+            removedItems.emplace(noteObjects[index]);
+    }
 
-            if (j != 0)
-                debugStream << ',';
-            debugStream << notesInBarBeat.size();
+    for (auto& change : result.changedWalls) {
+        wallObjects[change.index]->time = change.time;
+        wallObjects[change.index]->duration = change.duration;
+    }
+    for (auto& index : result.removedWalls) {
+        if (nodes)
+            removedNodes.emplace_back(nodes->walls[index]);
+        else
+            removedItems.emplace(wallObjects[index]);
+    }
 
-            if (notesInBarBeat.size() == 0)
-                continue;
+    int removedCount = removedNodes.size();
+    {
+        Generator::ScopedTimer timer(stats ? &stats->removeTime : nullptr);
+        for (auto node : removedNodes)
+            items->Remove(node);
+        if (!removedItems.empty())
+            removedCount = RemoveItems(items, removedItems);
+    }
+    GENERATOR_TRACE(Debug, "Removed %d objects", removedCount);
 
-            float currentBarBeatStart = firstBeatmapNoteTime + currentBarStart + j * dividedBarLength;
+    // new objects, merged into the list in one pass once sorted
+    std::vector<std::pair<float, BeatmapDataItem*>> insertedItems{};
+    insertedItems.reserve(result.rotations.size() + result.generatedWalls.size() + result.splitWalls.size());
 
-            // determine the rotation direction based on the last notes in the bar
-            float lastNoteTime = notesInBarBeat.back()->time;
-            std::vector<NoteData*> lastNotes{};
-            for (auto& note : notesInBarBeat) {
-                if (abs(note->time - lastNoteTime) < 0.005)
-                    lastNotes.emplace_back(note);
-            }
+    for (auto& rotation : result.rotations) {
+        auto type = rotation.early ? SpawnRotationBeatmapEventData::SpawnRotationEventType::Early : SpawnRotationBeatmapEventData::SpawnRotationEventType::Late;
+        insertedItems.emplace_back(rotation.time, SpawnRotationBeatmapEventData::New_ctor(rotation.time, type, rotation.amount * 15));
+    }
+    for (auto& wall : result.generatedWalls)
+        insertedItems.emplace_back(wall.time, CreateObstacle(wall));
+    for (auto& wall : result.splitWalls)
+        insertedItems.emplace_back(wall.time, CreateObstacle(wall));
 
-            // amount of notes pointing to the left/right of the last notes in the bar segment
-            auto [leftCount, rightCount] = LeftAndRightCounts(lastNotes);
-
-            // the next note after the bar segment
-            NoteData* afterLastNote = (k < notesInBar.size() ? notesInBar[k] : i < notes.size() ? notes[i] : nullptr);
-
-            // determine amount to rotate at once
-            // TODO: create formula out of these if statements
-            int rotationCount = 1;
-            if (afterLastNote != nullptr) {
-                float timeDiff = afterLastNote->time - lastNoteTime;
-                // only rotate once if there is only one note in the current bar segment
-                if (notesInBarBeat.size() >= 1) {
-                    // rotate thrice if you have an entire bar to react
-                    if (timeDiff >= barLength)
-                        rotationCount = 3;
-                    // rotate twice if you have an eighth of a bar to react
-                    else if (timeDiff >= barLength / 8)
-                        rotationCount = 2;
-                }
-            }
+    std::stable_sort(insertedItems.begin(), insertedItems.end(), [](auto& a, auto& b) { return a.first < b.first; });
 
-            int bottleneckRotations = is90Degree ? getConfig().BottleneckRotations90.GetValue() : getConfig().BottleneckRotations360.GetValue();
+    {
+        Generator::ScopedTimer timer(stats ? &stats->insertTime : nullptr);
+        ItemNode* lastInserted = nullptr;
+        InsertItems(data, insertedItems, nodes ? nodes->lastInserted : lastInserted);
+    }
+    GENERATOR_TRACE(Debug, "Inserted %lu objects", insertedItems.size());
 
-            int rotation = 0;
-            // most of the notes at the end are pointing to the left, rotate to the left
-            if (leftCount > rightCount)
-                rotation = -rotationCount;
-            // most of the notes at the end are pointing to the right, rotate to the right
-            else if (rightCount > leftCount)
-                rotation = rotationCount;
-            // equal direction in the last notes of the bar
-            else {
-                // prefer rotating to the left if moved a lot to the right
-                if (totalRotation >= bottleneckRotations)
-                    rotation = -rotationCount;
-                // prefer rotating to the right if moved a lot to the left
-                else if (totalRotation <= -bottleneckRotations)
-                    rotation = rotationCount;
-                // rotate based on previous direction
-                else
-                    rotation = previousDirection ? rotationCount : -rotationCount;
-            }
+    if (Generator::TraceEnabled(Generator::TraceLevel::Debug))
+        CheckEditedInstances(data, result, noteObjects, wallObjects);
+}
 
-            // don't rotate more than once (15 degrees) if rotating the other direction is preferred
-            if (totalRotation >= bottleneckRotations && rotationCount > 1)
-                rotationCount = 1;
-            else if (totalRotation <= -bottleneckRotations && rotationCount < -1)
-                rotationCount = -1;
-
-            // always rotate the other direction if past the rotation limit
-            if (totalRotation >= rotLimit - 1 && rotationCount > 0)
-                rotationCount = -rotationCount;
-            else if (totalRotation <= -rotLimit + 1 && rotationCount < 0)
-                rotationCount = -rotationCount;
-
-            // finally rotate after the last note with the calculated values
-            Rotate(lastNoteTime, rotation, SpawnRotationBeatmapEventData::SpawnRotationEventType::Late);
-
-            // TODO: change to preserve parity
-            if (getConfig().OnlyOneSaber.GetValue()) {
-                for (auto& note : notesInBarBeat) {
-                    // remove note
-                    if (note->colorType == (rotation > 0 ? ColorType::ColorA : ColorType::ColorB))
-                        items->Remove(note);
-                    else {
-                        // switch all notes to just one color
-                        if (note->colorType == (leftHanded ? ColorType::ColorB : ColorType::ColorA))
-                            note->Mirror(data->numberOfLines);
-                    }
-                }
-            }
+// a new beatmap holding the same objects as the level's own one, except copies of the ones the result edits
+// the copies are added in place of the originals, so both the list of all items and the lists by type hold them
+// events are shared too, added in the same order each gets the same neighbors of its type, only rotation events would get new ones and are copied
+// only for the base class, subclasses like the one for custom json data copy more than the items
+static BeatmapData* CopyOnWrite(BeatmapData* base, Generator::Result const& result, std::vector<NoteData*>& noteObjects, std::vector<ObstacleData*>& wallObjects) {
+    std::unordered_map<BeatmapDataItem*, BeatmapDataItem*> copies{};
+    for (auto& index : result.mirroredNotes) {
+        auto copy = reinterpret_cast<NoteData*>(noteObjects[index]->GetCopy());
+        copies.emplace(noteObjects[index], copy);
+        noteObjects[index] = copy;
+    }
+    for (auto& change : result.changedWalls) {
+        auto copy = reinterpret_cast<ObstacleData*>(wallObjects[change.index]->GetCopy());
+        copies.emplace(wallObjects[change.index], copy);
+        wallObjects[change.index] = copy;
+    }
 
-            // generate walls
-            if (getConfig().WallGenerator.GetValue() && !containsCustomWalls) {
-                float wallTime = currentBarBeatStart;
-                float wallDuration = dividedBarLength;
-
-                // check if there already is a wall
-                bool generateWall = true;
-                for (auto& wall : walls) {
-                    if (wall->time + wall->duration >= wallTime && wall->time < wallTime + wallDuration) {
-                        generateWall = false;
-                        break;
-                    }
-                }
-
-                if (generateWall && afterLastNote != nullptr) {
-                    bool anyLine0 = false;
-                    bool anyLine1 = false;
-                    bool anyLine2 = false;
-                    bool anyLine3 = false;
-                    for (auto& note : notesInBarBeat) {
-                        if (note->lineIndex == 0)
-                            anyLine0 = true;
-                        if (note->lineIndex == 1)
-                            anyLine1 = true;
-                        if (note->lineIndex == 2)
-                            anyLine2 = true;
-                        if (note->lineIndex == 3)
-                            anyLine3 = true;
-                        if (anyLine0 && anyLine1 && anyLine2 && anyLine3)
-                            break;
-                    }
-                    if (!anyLine0) {
-                        int wallHeight = anyLine1 ? 1 : 3;
-
-                        if (afterLastNote->lineIndex == 0 && !(wallHeight == 1 && afterLastNote->noteLineLayer == NoteLineLayer::Base))
-                            wallDuration = afterLastNote->time - getConfig().WallBackCut.GetValue() - wallTime;
-
-                        if (wallDuration > getConfig().MinWallDuration.GetValue())
-                            data->AddBeatmapObjectData(ObstacleData::New_ctor(wallTime, 0, wallHeight == 1 ? NoteLineLayer::Top : NoteLineLayer::Base, wallDuration, 1, wallHeight));
-                    }
-                    if (!anyLine3) {
-                        int wallHeight = anyLine2 ? 1 : 3;
-
-                        if (afterLastNote->lineIndex == 3 && !(wallHeight == 1 && afterLastNote->noteLineLayer == NoteLineLayer::Base))
-                            wallDuration = afterLastNote->time - getConfig().WallBackCut.GetValue() - wallTime;
-
-                        if (wallDuration > getConfig().MinWallDuration.GetValue())
-                            data->AddBeatmapObjectDataInOrder(ObstacleData::New_ctor(wallTime, 3, wallHeight == 1 ? NoteLineLayer::Top : NoteLineLayer::Base, wallDuration, 1, wallHeight));
-                    }
-                }
-            }
+    auto data = BeatmapData::New_ctor(base->numberOfLines);
+    auto keywords = base->get_specialBasicBeatmapEventKeywords()->GetEnumerator();
+    while (keywords->i_IEnumerator()->MoveNext())
+        data->AddSpecialBasicBeatmapEventKeyword(keywords->get_Current());
+
+    auto items = base->get_allBeatmapDataItems();
+    for (auto node = items->get_First(); node; node = node->get_Next()) {
+        auto item = node->get_Value();
+        if (auto copy = copies.find(item); copy != copies.end())
+            item = copy->second;
+        if (GetItemType(reinterpret_cast<Il2CppObject*>(item)->klass) != ItemType::Other)
+            data->AddBeatmapObjectDataInOrder(reinterpret_cast<BeatmapObjectData*>(item));
+        else if (auto object = il2cpp_utils::try_cast<BeatmapObjectData>(item))
+            data->AddBeatmapObjectDataInOrder(*object);
+        else if (il2cpp_utils::try_cast<SpawnRotationBeatmapEventData>(item))
+            data->InsertBeatmapEventDataInOrder(reinterpret_cast<BeatmapEventData*>(item->GetCopy()));
+        else if (auto event = il2cpp_utils::try_cast<BeatmapEventData>(item))
+            data->InsertBeatmapEventDataInOrder(*event);
+    }
+    GENERATOR_TRACE(Info, "Copied %lu of %d objects", copies.size(), items->get_Count());
+    return data;
+}
 
-            getLogger().info("%.2f | Rotate %d (c=%lu, lc=%d, rc=%d, lastNotes=%lu, rotationTime=%.2f, afterLastNote=%.2f, rotc=%d)",
-                currentBarBeatStart, rotation, notesInBarBeat.size(), leftCount, rightCount, lastNotes.size(), lastNoteTime + 0.01, afterLastNote ? afterLastNote->time : 0, rotationCount);
-        }
+// recent generations for each mode, to compare them without a profiler
+static Generator::StatsHistory history360{};
+static Generator::StatsHistory history90{};
+
+IReadonlyBeatmapData* Generate(IReadonlyBeatmapData* base, bool transformed, float bpm, bool is90Degree, bool leftHanded, std::string const& levelId, int difficulty, float spawnAheadTime) {
+    // the previous level is not playing anymore
+    StopStreaming();
+
+    Generator::Stats stats{};
+
+    // a copy made by the transforms is only used by this level, so it is edited directly
+    // the level's own data is copied on write once the result is known, only copying the objects it edits
+    // subclasses of it are copied whole before, and so is anything that might be streamed, which edits objects as it goes
+    float streamingHorizon = getConfig().StreamingHorizon.GetValue();
+    auto baseData = il2cpp_utils::try_cast<BeatmapData>(base).value_or(nullptr);
+    bool copyOnWrite = !transformed && baseData && reinterpret_cast<Il2CppObject*>(baseData)->klass == classof(BeatmapData*) && streamingHorizon <= 0;
+    BeatmapData* data = nullptr;
+    if (!copyOnWrite) {
+        Generator::ScopedTimer timer(&stats.copyTime);
+        if (transformed && baseData)
+            data = baseData;
+        else
+            data = base->GetCopy();
+    }
 
-        getLogger().info("%.2f (%.2f) -> %.2f(%.2f) | count=%lu segments=%s barDiviver=%d",
-            currentBarStart + firstBeatmapNoteTime, (currentBarStart + firstBeatmapNoteTime) / beatDuration, currentBarEnd + firstBeatmapNoteTime, (currentBarEnd + firstBeatmapNoteTime) / beatDuration, notesInBar.size(), debugStream.str().c_str(), barDivider);
+    // filter the beatmap data to find all notes and walls, keeping the objects to apply the results to
+    std::vector<NoteData*> noteObjects{};
+    std::vector<ObstacleData*> wallObjects{};
+    ItemNodes nodes{};
+    std::vector<Generator::Note> notes{};
+    std::vector<Generator::Wall> walls{};
+    {
+        Generator::ScopedTimer timer(&stats.extractTime);
+        ExtractItems(copyOnWrite ? base : data->i_IReadonlyBeatmapData(), notes, walls, &noteObjects, &wallObjects, streamingHorizon > 0 ? &nodes : nullptr);
     }
 
-    // cut walls, walls will be cut when a rotation event is emitted
-    std::deque<ObstacleData*> wallQueue{walls.begin(), walls.end()};
+    if (notes.empty()) {
+        getLogger().info("No notes to generate from");
+        // nothing is edited, so the level's own data can be played as is
+        return copyOnWrite ? base : data->i_IReadonlyBeatmapData();
+    }
 
-    float wallFrontCut = getConfig().WallFrontCut.GetValue();
-    float wallBackCut = getConfig().WallBackCut.GetValue();
-    float minWallDur = getConfig().MinWallDuration.GetValue();
+    auto key = GetCacheKey(levelId, difficulty, is90Degree, leftHanded);
+    uint64_t inputHash = Generator::HashInput(notes, walls);
 
-    while (wallQueue.size() > 0) {
-        auto wall = wallQueue.front();
-        wallQueue.pop_front();
-        for (auto& [cutTime, cutAmount] : wallCutMoments) {
-            if (wall->duration <= 0)
-                break;
+    auto params = GetParams(bpm, is90Degree, leftHanded, data->numberOfLines);
 
-            // do not cut a margin around the wall if the wall is at a custom position
-            bool isCustomWall = false;
-            // if (wall->customData != null)
-            //     isCustomWall = wall->customData.ContainsKey("_position");
-            float frontCut = isCustomWall ? 0 : wallFrontCut;
-            float backCut = isCustomWall ? 0 : wallBackCut;
-
-            // walls with this criteria are not fun in 360, remove it
-            if (!isCustomWall && (wall->lineIndex == 1 || wall->lineIndex == 2 || (wall->lineIndex == 0 && wall->width > 1)))
-                items->Remove(wall);
-            // ff moved in direction of wall
-            else if (isCustomWall || (wall->lineIndex <= 1 && cutAmount < 0) || (wall->lineIndex >= 2 && cutAmount > 0)) {
-                int cutMultiplier = abs(cutAmount);
-                if (cutTime > wall->time - frontCut && cutTime < wall->time + wall->duration + backCut * cutMultiplier) {
-                    float originalTime = wall->time;
-                    float originalDuration = wall->duration;
-
-                    // 225.431: 225.631(0.203476) -> 225.631() <|> 225.631(0.203476)
-                    float firstPartTime = wall->time; // 225.631
-                    float firstPartDuration = (cutTime - backCut * cutMultiplier) - firstPartTime; // -0.6499969
-                    float secondPartTime = cutTime + frontCut; // 225.631
-                    float secondPartDuration = (wall->time + wall->duration) - secondPartTime; //0.203476
-
-                    // update duration of existing obstacle
-                    if (firstPartDuration >= minWallDur && secondPartDuration >= minWallDur) {
-                        wall->duration = firstPartDuration;
-
-                        // And create a new obstacle after it
-                        auto secondPart = ObstacleData::New_ctor(secondPartTime, wall->lineIndex, wall->lineLayer, secondPartDuration, wall->width, wall->height);
-                        data->AddBeatmapObjectDataInOrder(secondPart);
-                        wallQueue.emplace_back(secondPart);
-                    }
-                    // just update the existing obstacle, the second piece of the cut wall is too small
-                    else if (firstPartDuration >= minWallDur)
-                        wall->duration = firstPartDuration;
-                    // Reuse the obstacle and use it as second part
-                    else if (secondPartDuration >= minWallDur) {
-                        if (secondPartTime != wall->time && secondPartDuration != wall->duration) {
-                            wall->time = secondPartTime;
-                            wall->duration = secondPartDuration;
-                            wallQueue.emplace_back(wall);
-                        }
-                    }
-                    // When this wall is cut, both pieces are too small, remove it
-                    else
-                        items->Remove(wall);
-
-                    getLogger().info("Split wall at %.2f: %.2f(%.2f) -> %.2f(%.2f) <|> %.2f(%.2f) cutMultiplier=%d",
-                        cutTime, originalTime, originalDuration, firstPartTime, firstPartDuration, secondPartTime, secondPartDuration, cutMultiplier);
-                }
-            }
-        }
-    }
+    auto& cache = GetResultCache();
+    int cacheSize = getConfig().CacheSize.GetValue();
+    if (cacheSize <= 0)
+        cache.Clear();
+    cache.SetMaxBytes(cacheSize * 1024 * 1024);
 
-    // remove bombs around cut walls
-    for (auto& note : notes) {
-        if (note->cutDirection != NoteCutDirection::None)
-            continue;
+    auto& diskCache = GetDiskCache();
+    int diskCacheSize = getConfig().DiskCacheSize.GetValue();
+    diskCache.SetMaxBytes(diskCacheSize * 1024 * 1024);
 
-        for (auto& [cutTime, cutAmount] : wallCutMoments) {
-            if (note->time >= cutTime - wallFrontCut && note->time < cutTime + wallBackCut &&
-                    ((note->lineIndex <= 2 && cutAmount < 0) || (note->lineIndex >= 1 && cutAmount > 0))) {
-                items->Remove(note);
-                break;
+    Generator::Result const* cached = cacheSize > 0 ? cache.Find(key, inputHash) : nullptr;
+    std::optional<Generator::Result> result{};
+    if (cached)
+        getLogger().info("Using cached result (hits=%d misses=%d)", cache.GetHits(), cache.GetMisses());
+    else {
+        // the pregeneration has already saved its result to the disk cache
+        result = TakePregenerated(key, inputHash);
+        if (result)
+            getLogger().info("Using pregenerated result");
+        else {
+            if (diskCacheSize > 0)
+                result = diskCache.Load(key, inputHash);
+            if (result)
+                getLogger().info("Using result cached on disk");
+            else if (streamingHorizon > 0) {
+                // the stream applies the result and caches it once done
+                StartStreaming(data, notes, walls, params, std::move(noteObjects), std::move(wallObjects), std::move(nodes), key, inputHash, streamingHorizon, spawnAheadTime);
+                return data->i_IReadonlyBeatmapData();
+            }
+            else {
+                // the player is waiting, so the bars are analyzed on the pregeneration workers too
+                result = Generator::Generate(notes, walls, params, &stats, &GetPregenerationPool());
+                if (diskCacheSize > 0 && !diskCache.Save(key, inputHash, *result))
+                    getLogger().error("Failed to save result to %s", diskCache.GetPath(key).c_str());
             }
         }
+        if (cacheSize > 0) {
+            cached = &cache.Insert(key, inputHash, std::move(*result));
+            getLogger().info("Cached result (hits=%d misses=%d entries=%lu size=%luKB)", cache.GetHits(), cache.GetMisses(), cache.GetCount(), cache.GetUsedBytes() / 1024);
+        }
+    }
+    auto& applied = cached ? *cached : *result;
+    if (copyOnWrite) {
+        Generator::ScopedTimer timer(&stats.copyTime);
+        data = CopyOnWrite(baseData, applied, noteObjects, wallObjects);
+    }
+    ApplyResult(data, applied, noteObjects, wallObjects, &stats, nullptr);
+
+    getLogger().info("Stats: %s", Generator::FormatStats(stats).c_str());
+    // only full generations, results from a cache would lower the averages
+    if (stats.notes > 0) {
+        auto& history = is90Degree ? history90 : history360;
+        history.Add(stats);
+        getLogger().info("Average of last %d %s generations: %s", history.GetCount(), is90Degree ? "90" : "360", Generator::FormatStats(history.Average()).c_str());
     }
-
-    getLogger().info("Emitted %d rotation events", eventCount);
 
     return data->i_IReadonlyBeatmapData();
 }
@@ -1,6 +1,7 @@
 #include "main.hpp"
 #include "config.hpp"
 #include "generator.hpp"
+#include "core/trace.hpp"
 
 using namespace GlobalNamespace;
 
@@ -11,9 +12,21 @@ Logger& getLogger() {
     return *logger;
 }
 
+ModInfo& getModInfo() {
+    return modInfo;
+}
+
 #include "GlobalNamespace/BeatmapCharacteristicSO.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
 SafePtr<List<BeatmapCharacteristicSO*>> generatedCharacteristics;
+// lookups into the list above, which keeps the characteristics alive
+std::unordered_map<std::string, BeatmapCharacteristicSO*> generatedCharacteristicsByName;
+std::unordered_set<BeatmapCharacteristicSO*> generatedCharacteristicsSet;
 
 #define SUFFIX_360 "-Generated360"
 #define SUFFIX_90 "-Generated90"
@@ -61,6 +74,10 @@ void CreateCustomCharacteristics() {
 
         generatedCharacteristics->Add(generated360);
         generatedCharacteristics->Add(generated90);
+        for (auto generated : {generated360, generated90}) {
+            generatedCharacteristicsByName[generated->serializedName] = generated;
+            generatedCharacteristicsSet.insert(generated);
+        }
     }
 
     ArrayW<BeatmapCharacteristicSO*> newChars{currentChars.Length() + generatedCharacteristics->get_Count()};
@@ -69,24 +86,13 @@ void CreateCustomCharacteristics() {
     mainSystemInit->beatmapCharacteristicCollection->beatmapCharacteristics = newChars;
 }
 
-BeatmapCharacteristicSO* GetCustomCharacteristic(std::string_view name) {
-    if (!generatedCharacteristics)
-        return nullptr;
-    for (auto& c : ListW<BeatmapCharacteristicSO*>(generatedCharacteristics.ptr())) {
-        if (c->serializedName == name)
-            return c;
-    }
-    return nullptr;
+BeatmapCharacteristicSO* GetCustomCharacteristic(std::string const& name) {
+    auto found = generatedCharacteristicsByName.find(name);
+    return found != generatedCharacteristicsByName.end() ? found->second : nullptr;
 }
 
 bool IsCustomCharacteristic(BeatmapCharacteristicSO* characteristic) {
-    if (!generatedCharacteristics)
-        return false;
-    for (auto& c : ListW<BeatmapCharacteristicSO*>(generatedCharacteristics.ptr())) {
-        if (c == characteristic)
-            return true;
-    }
-    return false;
+    return generatedCharacteristicsSet.contains(characteristic);
 }
 
 #include "GlobalNamespace/PlayerDataFileManagerSO.hpp"
@@ -157,56 +163,163 @@ IDifficultyBeatmapSet* CopyBeatmapSet(IDifficultyBeatmapSet* set, IBeatmapLevel*
 
 #include "GlobalNamespace/StandardLevelDetailView.hpp"
 #include "GlobalNamespace/BeatmapLevelData.hpp"
+#include "pregen.hpp"
+
+using DifficultyBeatmapSets = System::Collections::Generic::IReadOnlyList_1<IDifficultyBeatmapSet*>;
+
+struct GeneratedSetsSettings {
+    std::string basedOn;
+    bool show360;
+    bool show90;
+
+    bool operator==(GeneratedSetsSettings const&) const = default;
+};
+
+struct GeneratedSets {
+    // the list given to the level data, if it was replaced the sets have to be added again
+    // all are kept alive, so a new list or set can't be given the address of a collected one
+    SafePtr<DifficultyBeatmapSets> assigned;
+    SafePtr<IDifficultyBeatmapSet> set360;
+    SafePtr<IDifficultyBeatmapSet> set90;
+};
+
+// levels with memoized sets, the oldest are dropped so the kept sets don't grow with the library
+constexpr int MaxGeneratedSets = 64;
+
+// by level id, for the settings they were made with
+GeneratedSetsSettings generatedSetsSettings{};
+std::unordered_map<std::string, GeneratedSets> generatedSets;
+// level ids in the order they were added
+std::deque<std::string> generatedSetsOrder;
+
+static IDifficultyBeatmapSet* GetSet(SafePtr<IDifficultyBeatmapSet> const& set) {
+    return set ? set.ptr() : nullptr;
+}
+
+// the memoized sets are only used while the level data still has them
+static bool IsCurrent(GeneratedSets const& memo, BeatmapLevelData* levelData) {
+    if (!memo.assigned || memo.assigned.ptr() != levelData->difficultyBeatmapSets)
+        return false;
+    ArrayW<IDifficultyBeatmapSet*> sets(levelData->difficultyBeatmapSets);
+    for (auto set : {GetSet(memo.set360), GetSet(memo.set90)}) {
+        if (set && std::find(sets.begin(), sets.end(), set) == sets.end())
+            return false;
+    }
+    return true;
+}
+
+static void Memoize(std::string const& levelId, DifficultyBeatmapSets* assigned, IDifficultyBeatmapSet* set360, IDifficultyBeatmapSet* set90) {
+    if (!generatedSets.contains(levelId)) {
+        if (generatedSetsOrder.size() >= MaxGeneratedSets) {
+            generatedSets.erase(generatedSetsOrder.front());
+            generatedSetsOrder.pop_front();
+        }
+        generatedSetsOrder.push_back(levelId);
+    }
+    auto& memo = generatedSets[levelId];
+    memo = {};
+    memo.assigned = assigned;
+    if (set360)
+        memo.set360 = set360;
+    if (set90)
+        memo.set90 = set90;
+}
 
 MAKE_HOOK_MATCH(StandardLevelDetailView_SetContent, &StandardLevelDetailView::SetContent, void, StandardLevelDetailView* self, IBeatmapLevel* level, BeatmapDifficulty defaultDifficulty, BeatmapCharacteristicSO* defaultBeatmapCharacteristic, PlayerData* playerData) {
 
     auto levelData = (BeatmapLevelData*) level->get_beatmapLevelData();
-    // boy do I love it when interfaces are set to types that don't even inherit from them
-    ArrayW<IDifficultyBeatmapSet*> originalSets(levelData->difficultyBeatmapSets);
+
+    GeneratedSetsSettings settings{getConfig().BasedOn.GetValue(), getConfig().Show360.GetValue(), getConfig().Show90.GetValue()};
+    if (settings != generatedSetsSettings) {
+        generatedSets.clear();
+        generatedSetsOrder.clear();
+        generatedSetsSettings = settings;
+    }
 
     IDifficultyBeatmapSet* newSet360 = nullptr;
     IDifficultyBeatmapSet* newSet90 = nullptr;
 
-    if (auto baseCharSet = GetCharacteristic(level, getConfig().BasedOn.GetValue())) {
-        if (getConfig().Show360.GetValue()) {
-            std::string name = getConfig().BasedOn.GetValue() + SUFFIX_360;
-            if (auto preexisting = GetCharacteristic(level, name))
-                newSet360 = preexisting;
-            else {
-                getLogger().info("Adding generated 360 degree level to standard detail view");
-                newSet360 = CopyBeatmapSet(baseCharSet, level, GetCustomCharacteristic(name));
+    std::string levelId = level->i_IPreviewBeatmapLevel()->get_levelID();
+    auto memo = generatedSets.find(levelId);
+    if (memo != generatedSets.end() && IsCurrent(memo->second, levelData)) {
+        newSet360 = GetSet(memo->second.set360);
+        newSet90 = GetSet(memo->second.set90);
+    }
+    else {
+        // boy do I love it when interfaces are set to types that don't even inherit from them
+        ArrayW<IDifficultyBeatmapSet*> originalSets(levelData->difficultyBeatmapSets);
+
+        if (auto baseCharSet = GetCharacteristic(level, settings.basedOn)) {
+            if (settings.show360) {
+                std::string name = settings.basedOn + SUFFIX_360;
+                if (auto preexisting = GetCharacteristic(level, name))
+                    newSet360 = preexisting;
+                else {
+                    getLogger().info("Adding generated 360 degree level to standard detail view");
+                    newSet360 = CopyBeatmapSet(baseCharSet, level, GetCustomCharacteristic(name));
+                }
+            }
+            if (settings.show90) {
+                std::string name = settings.basedOn + SUFFIX_90;
+                if (auto preexisting = GetCharacteristic(level, name))
+                    newSet90 = preexisting;
+                else {
+                    getLogger().info("Adding generated 90 degree level to standard detail view");
+                    newSet90 = CopyBeatmapSet(baseCharSet, level, GetCustomCharacteristic(name));
+                }
             }
         }
-        if (getConfig().Show90.GetValue()) {
-            std::string name = getConfig().BasedOn.GetValue() + SUFFIX_90;
-            if (auto preexisting = GetCharacteristic(level, name))
-                newSet90 = preexisting;
-            else {
-                getLogger().info("Adding generated 90 degree level to standard detail view");
-                newSet90 = CopyBeatmapSet(baseCharSet, level, GetCustomCharacteristic(name));
+        if (newSet360 || newSet90) {
+            auto newSets = List<IDifficultyBeatmapSet*>::New_ctor(originalSets.Length());
+            for (auto& difficultySet : originalSets) {
+                if (IsCustomCharacteristic(difficultySet->get_beatmapCharacteristic()))
+                    continue;
+                newSets->Add(difficultySet);
             }
+            if (newSet360)
+                newSets->Add(newSet360);
+            if (newSet90)
+                newSets->Add(newSet90);
+            // keep its underlying type consistent... T-T
+            levelData->difficultyBeatmapSets = (DifficultyBeatmapSets*) newSets->ToArray().convert();
         }
+        Memoize(levelId, levelData->difficultyBeatmapSets, newSet360, newSet90);
     }
-    if (newSet360 || newSet90) {
-        auto newSets = List<IDifficultyBeatmapSet*>::New_ctor(originalSets.Length());
-        for (auto& difficultySet : originalSets) {
-            if (IsCustomCharacteristic(difficultySet->get_beatmapCharacteristic()))
-                continue;
-            newSets->Add(difficultySet);
-        }
+
+    StandardLevelDetailView_SetContent(self, level, defaultDifficulty, defaultBeatmapCharacteristic, playerData);
+
+    // the generated sets are ready to be shown, so every difficulty in them can be started in the background
+    if (getConfig().Pregenerate.GetValue() && getConfig().PregenerateSet.GetValue()) {
         if (newSet360)
-            newSets->Add(newSet360);
+            StartSetPregeneration(newSet360, defaultDifficulty, playerData, false);
         if (newSet90)
-            newSets->Add(newSet90);
-        // keep its underlying type consistent... T-T
-        levelData->difficultyBeatmapSets = (System::Collections::Generic::IReadOnlyList_1<IDifficultyBeatmapSet*>*) newSets->ToArray().convert();
+            StartSetPregeneration(newSet90, defaultDifficulty, playerData, true);
     }
+}
 
-    StandardLevelDetailView_SetContent(self, level, defaultDifficulty, defaultBeatmapCharacteristic, playerData);
+MAKE_HOOK_MATCH(StandardLevelDetailView_RefreshContent, &StandardLevelDetailView::RefreshContent, void, StandardLevelDetailView* self) {
+
+    StandardLevelDetailView_RefreshContent(self);
+
+    if (!getConfig().Pregenerate.GetValue())
+        return;
+
+    auto difficultyBeatmap = self->get_selectedDifficultyBeatmap();
+    if (!difficultyBeatmap)
+        return;
+
+    StringW characteristic = difficultyBeatmap->get_parentDifficultyBeatmapSet()->get_beatmapCharacteristic()->serializedName;
+    bool generated360 = characteristic.ends_with(SUFFIX_360);
+    bool generated90 = characteristic.ends_with(SUFFIX_90);
+    if (generated360 || generated90)
+        StartPregeneration(difficultyBeatmap, self->playerData, generated90);
 }
 
 bool startingGenerated360 = false;
 bool startingGenerated90 = false;
+int startingDifficulty = 0;
+float startingNoteJumpSpeed = 0;
+float startingNoteJumpOffset = 0;
 
 #include "GlobalNamespace/SinglePlayerLevelSelectionFlowCoordinator.hpp"
 #include "bs-utils/shared/utils.hpp"
@@ -216,6 +329,9 @@ MAKE_HOOK_MATCH(SinglePlayerLevelSelectionFlowCoordinator_StartLevel, &SinglePla
     StringW startingCharacteristic = self->get_selectedDifficultyBeatmap()->get_parentDifficultyBeatmapSet()->get_beatmapCharacteristic()->serializedName;
     startingGenerated360 = startingCharacteristic.ends_with(SUFFIX_360);
     startingGenerated90 = startingCharacteristic.ends_with(SUFFIX_90);
+    startingDifficulty = self->get_selectedDifficultyBeatmap()->get_difficulty().value;
+    startingNoteJumpSpeed = self->get_selectedDifficultyBeatmap()->get_noteJumpMovementSpeed();
+    startingNoteJumpOffset = self->get_selectedDifficultyBeatmap()->get_noteJumpStartBeatOffset();
 
     // if ((startingGenerated360 || startingGenerated90) && !SettingsAreDefault(startingGenerated90))
     if (startingGenerated360 || startingGenerated90)
@@ -228,6 +344,7 @@ MAKE_HOOK_MATCH(SinglePlayerLevelSelectionFlowCoordinator_StartLevel, &SinglePla
 
 #include "GlobalNamespace/BeatmapDataTransformHelper.hpp"
 #include "GlobalNamespace/EnvironmentEffectsFilterPreset.hpp"
+#include "stream.hpp"
 
 MAKE_HOOK_MATCH(BeatmapDataTransformHelper_CreateTransformedBeatmapData, &BeatmapDataTransformHelper::CreateTransformedBeatmapData,
         IReadonlyBeatmapData*, IReadonlyBeatmapData* beatmapData, IPreviewBeatmapLevel* beatmapLevel, GameplayModifiers* gameplayModifiers, bool leftHanded, EnvironmentEffectsFilterPreset environmentEffectsFilterPreset, EnvironmentIntensityReductionOptions* environmentIntensityReductionOptions, MainSettingsModelSO* mainSettingsModel) {
@@ -237,11 +354,23 @@ MAKE_HOOK_MATCH(BeatmapDataTransformHelper_CreateTransformedBeatmapData, &Beatma
     if (startingGenerated360 || startingGenerated90) {
         getLogger().info("Generating rotation events for Generated %s Degree mode", startingGenerated90 ? "90" : "360");
 
-        ret = Generate(ret, beatmapLevel->get_beatsPerMinute(), startingGenerated90, leftHanded);
+        // without any transforms the level's own data is returned, that must not be edited
+        float bpm = beatmapLevel->get_beatsPerMinute();
+        ret = Generate(ret, ret != beatmapData, bpm, startingGenerated90, leftHanded, beatmapLevel->get_levelID(), startingDifficulty,
+            SpawnAheadTime(bpm, startingNoteJumpSpeed, startingNoteJumpOffset));
     }
     return ret;
 }
 
+#include "GlobalNamespace/AudioTimeSyncController.hpp"
+
+MAKE_HOOK_MATCH(AudioTimeSyncController_Update, &AudioTimeSyncController::Update, void, AudioTimeSyncController* self) {
+
+    AudioTimeSyncController_Update(self);
+
+    ContinueStreaming(self->get_songTime());
+}
+
 extern "C" void setup(ModInfo& info) {
     info.id = MOD_ID;
     info.version = VERSION;
@@ -257,12 +386,18 @@ extern "C" void load() {
 
     getConfig().Init(modInfo);
 
+    Generator::SetLogFunction([](char const* message) { getLogger().info("%s", message); });
+    Generator::SetTraceLevel((Generator::TraceLevel) getConfig().TraceLevel.GetValue());
+    getConfig().TraceLevel.AddChangeEvent([](int value) { Generator::SetTraceLevel((Generator::TraceLevel) value); });
+
     QuestUI::Register::RegisterGameplaySetupMenu(modInfo, QuestUI::Register::MenuType::Solo, GameplaySetup);
 
     getLogger().info("Installing hooks...");
     INSTALL_HOOK(getLogger(), PlayerDataFileManagerSO_LoadFromCurrentVersion);
     INSTALL_HOOK(getLogger(), StandardLevelDetailView_SetContent);
+    INSTALL_HOOK(getLogger(), StandardLevelDetailView_RefreshContent);
     INSTALL_HOOK(getLogger(), SinglePlayerLevelSelectionFlowCoordinator_StartLevel);
     INSTALL_HOOK(getLogger(), BeatmapDataTransformHelper_CreateTransformedBeatmapData);
+    INSTALL_HOOK(getLogger(), AudioTimeSyncController_Update);
     getLogger().info("Installed all hooks!");
 }
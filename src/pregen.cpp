@@ -0,0 +1,232 @@
+#include "main.hpp"
+#include "config.hpp"
+#include "generator.hpp"
+#include "pregen.hpp"
+#include "core/stats.hpp"
+#include "core/threadpool.hpp"
+
+
+#include "GlobalNamespace/IBeatmapLevel.hpp"
+#include "GlobalNamespace/IPreviewBeatmapLevel.hpp"
+#include "GlobalNamespace/EnvironmentInfoSO.hpp"
+#include "GlobalNamespace/PlayerSpecificSettings.hpp"
+#include "GlobalNamespace/BeatmapData.hpp"
+#include "System/Threading/Tasks/Task_1.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <stdexcept>
+
+using namespace GlobalNamespace;
+
+using BeatmapDataTask = System::Threading::Tasks::Task_1<IReadonlyBeatmapData*>;
+
+using PregenerationResult = std::pair<uint64_t, Generator::Result>;
+
+// how long the level load waits for an unfinished pregeneration before generating itself
+// the worker can be waiting for the beatmap data, which may need the main thread to load
+constexpr auto TakeBudget = std::chrono::milliseconds(50);
+// how long a worker waits for the beatmap data before giving up, so it can't be blocked forever
+constexpr int LoadTimeoutMilliseconds = 30000;
+
+struct Pregeneration {
+    Generator::CacheKey key;
+    // kept alive until the worker is done with it, only created and destroyed on the main thread
+    SafePtr<BeatmapDataTask> task;
+    // input hash and result
+    std::shared_future<PregenerationResult> future;
+};
+
+// only accessed on the main thread, the workers just fulfill their promises
+static std::vector<Pregeneration> pregenerations{};
+// ones that weren't ready when their level loaded, kept until they are done so their task and memory are released then
+static std::vector<Pregeneration> abandoned{};
+// the finished results kept above, and estimates for the ones being generated
+static std::atomic<size_t> pregenerationBytes = 0;
+// never destroyed, the game doesn't wait for its workers on exit
+static Generator::ThreadPool* pool = nullptr;
+
+static bool IsReady(Pregeneration const& pregeneration) {
+    return pregeneration.future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// waits for the result, then stops counting its memory
+static PregenerationResult Release(Pregeneration const& pregeneration) {
+    auto result = pregeneration.future.get();
+    pregenerationBytes -= Generator::ResultSize(result.second);
+    return result;
+}
+
+static void ReleaseAbandoned() {
+    std::erase_if(abandoned, [](auto& pregeneration) {
+        if (!IsReady(pregeneration))
+            return false;
+        Release(pregeneration);
+        return true;
+    });
+}
+
+static void Finish(std::promise<PregenerationResult>& promise, uint64_t inputHash, Generator::Result result) {
+    pregenerationBytes += Generator::ResultSize(result);
+    promise.set_value({inputHash, std::move(result)});
+}
+
+static Generator::ThreadPool& GetPool() {
+    int threads = std::max(getConfig().PregenerateThreads.GetValue(), 1);
+    // a changed setting is applied once the current workers are idle
+    if (pool && pool->GetThreadCount() != threads && std::all_of(pregenerations.begin(), pregenerations.end(), IsReady)
+            && std::all_of(abandoned.begin(), abandoned.end(), IsReady)) {
+        delete pool;
+        pool = nullptr;
+    }
+    if (!pool)
+        pool = new Generator::ThreadPool(threads);
+    return *pool;
+}
+
+Generator::ThreadPool& GetPregenerationPool() {
+    return GetPool();
+}
+
+// optional pregenerations are skipped if their result would go over the memory limit
+static void Start(IDifficultyBeatmap* difficultyBeatmap, PlayerData* playerData, bool is90Degree, bool optional) {
+    auto level = difficultyBeatmap->get_level();
+    auto previewLevel = level->i_IPreviewBeatmapLevel();
+    bool leftHanded = playerData->playerSpecificSettings->leftHanded;
+    auto key = GetCacheKey(previewLevel->get_levelID(), difficultyBeatmap->get_difficulty().value, is90Degree, leftHanded);
+
+    ReleaseAbandoned();
+    auto found = std::find_if(pregenerations.begin(), pregenerations.end(), [&key](auto& pregeneration) { return pregeneration.key == key; });
+    if (found != pregenerations.end()) {
+        // one that was skipped is started again when it is selected
+        if (optional || !IsReady(*found) || found->future.get().first != 0)
+            return;
+        Release(*found);
+        pregenerations.erase(found);
+    }
+    if (GetResultCache().Contains(key) || std::filesystem::exists(GetDiskCache().GetPath(key)))
+        return;
+    // results for other levels that were not used are dropped, they are still in the disk cache
+    std::erase_if(pregenerations, [&key](auto& pregeneration) {
+        if (pregeneration.key.levelId == key.levelId || !IsReady(pregeneration))
+            return false;
+        Release(pregeneration);
+        return true;
+    });
+
+    getLogger().info("Pregenerating %s difficulty %d", is90Degree ? "90" : "360", key.difficulty);
+
+    // config values are read here, the worker only uses the snapshot
+    float bpm = previewLevel->get_beatsPerMinute();
+    auto params = GetParams(bpm, is90Degree, leftHanded, 4);
+    int diskCacheSize = getConfig().DiskCacheSize.GetValue();
+    size_t maxBytes = (size_t) std::max(getConfig().PregenerateMemory.GetValue(), 0) * 1024 * 1024;
+    auto cacheDirectory = GetDiskCache().GetDirectory();
+
+    // the worker only gets the pointer, the reference kept with the pregeneration isn't touched off the main thread
+    BeatmapDataTask* task = difficultyBeatmap->GetBeatmapDataAsync(previewLevel->get_environmentInfo(), playerData->playerSpecificSettings);
+
+    // shared so the job can be copied into the pool
+    auto promise = std::make_shared<std::promise<PregenerationResult>>();
+    pregenerations.push_back({key, task, promise->get_future().share()});
+
+    GetPool().Submit([task, key, params, optional, maxBytes, diskCacheSize, cacheDirectory, promise]() mutable {
+        std::vector<Generator::Note> notes{};
+        std::vector<Generator::Wall> walls{};
+
+        // snapshot the notes and walls, the rest of the work doesn't touch il2cpp
+        auto thread = il2cpp_functions::thread_attach(il2cpp_functions::domain_get());
+        bool loaded = true;
+        try {
+            if (!task->Wait(LoadTimeoutMilliseconds))
+                throw std::runtime_error("timed out");
+            auto data = task->get_Result();
+            if (auto beatmapData = il2cpp_utils::try_cast<BeatmapData>(data))
+                params.numberOfLines = (*beatmapData)->numberOfLines;
+            ExtractItems(data, notes, walls, nullptr, nullptr, nullptr);
+        } catch (...) {
+            loaded = false;
+        }
+        il2cpp_functions::thread_detach(thread);
+
+        if (!loaded || notes.empty()) {
+            getLogger().info("Failed to load beatmap data for pregeneration");
+            Finish(*promise, 0, {});
+            return;
+        }
+
+        // the snapshot, the generator's copies of it and about as much again for the result
+        size_t estimate = 3 * (notes.size() * sizeof(Generator::Note) + walls.size() * sizeof(Generator::Wall));
+        size_t usedBytes = pregenerationBytes.fetch_add(estimate) + estimate;
+        if (optional && usedBytes > maxBytes) {
+            pregenerationBytes -= estimate;
+            getLogger().info("Skipped pregenerating difficulty %d, over the memory limit", key.difficulty);
+            Finish(*promise, 0, {});
+            return;
+        }
+
+        // left handed mode mirrors the beatmap before it gets to the generator
+        if (params.leftHanded) {
+            for (auto& note : notes)
+                Generator::Mirror(note, params.numberOfLines);
+            for (auto& wall : walls)
+                Generator::Mirror(wall, params.numberOfLines);
+        }
+
+        Generator::Stats stats{};
+        auto result = Generator::Generate(notes, walls, params, &stats);
+        getLogger().info("Pregenerated difficulty %d: %s", key.difficulty, Generator::FormatStats(stats).c_str());
+
+        uint64_t inputHash = Generator::HashInput(notes, walls);
+        if (diskCacheSize > 0)
+            Generator::DiskCache(cacheDirectory, diskCacheSize * 1024 * 1024).Save(key, inputHash, result);
+        pregenerationBytes -= estimate;
+        Finish(*promise, inputHash, std::move(result));
+    });
+}
+
+void StartPregeneration(IDifficultyBeatmap* difficultyBeatmap, PlayerData* playerData, bool is90Degree) {
+    Start(difficultyBeatmap, playerData, is90Degree, false);
+}
+
+void StartSetPregeneration(IDifficultyBeatmapSet* set, BeatmapDifficulty shownDifficulty, PlayerData* playerData, bool is90Degree) {
+    ArrayW<IDifficultyBeatmap*> difficultyBeatmaps(set->get_difficultyBeatmaps());
+
+    // submitted first, so the shown one starts before the rest
+    for (auto difficultyBeatmap : difficultyBeatmaps) {
+        if (difficultyBeatmap->get_difficulty().value == shownDifficulty.value)
+            Start(difficultyBeatmap, playerData, is90Degree, false);
+    }
+    for (auto difficultyBeatmap : difficultyBeatmaps) {
+        if (difficultyBeatmap->get_difficulty().value != shownDifficulty.value)
+            Start(difficultyBeatmap, playerData, is90Degree, true);
+    }
+}
+
+std::optional<Generator::Result> TakePregenerated(Generator::CacheKey const& key, uint64_t inputHash) {
+    auto found = std::find_if(pregenerations.begin(), pregenerations.end(), [&key](auto& pregeneration) { return pregeneration.key == key; });
+    if (found == pregenerations.end())
+        return std::nullopt;
+
+    ReleaseAbandoned();
+    if (found->future.wait_for(TakeBudget) != std::future_status::ready) {
+        getLogger().info("Pregeneration is not done, generating again");
+        abandoned.push_back(std::move(*found));
+        pregenerations.erase(found);
+        return std::nullopt;
+    }
+    auto [pregeneratedHash, result] = Release(*found);
+    pregenerations.erase(found);
+
+    // skipped or failed
+    if (pregeneratedHash == 0)
+        return std::nullopt;
+    if (pregeneratedHash != inputHash) {
+        getLogger().info("Pregenerated result is for different notes, generating again");
+        return std::nullopt;
+    }
+    return result;
+}
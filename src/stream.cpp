@@ -0,0 +1,110 @@
+#include "main.hpp"
+#include "config.hpp"
+#include "generator.hpp"
+#include "stream.hpp"
+#include "core/stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+
+using namespace GlobalNamespace;
+
+// time spent generating in each frame while the level plays
+constexpr auto FrameBudget = std::chrono::microseconds(500);
+// the objects spawning in the next frames are edited too, in case the game spawns them before the next update
+constexpr float SpawnMargin = 0.1f;
+
+struct Stream {
+    // the data the level is playing, kept alive until the stream is done
+    SafePtr<BeatmapData> data;
+    std::vector<NoteData*> noteObjects;
+    std::vector<ObstacleData*> wallObjects;
+    // each publish only touches the nodes it edits
+    ItemNodes nodes;
+    Generator::CacheKey key;
+    uint64_t inputHash;
+    float horizon;
+    float spawnAheadTime;
+    // the session keeps a pointer to the stats
+    std::unique_ptr<Generator::Stats> stats;
+    std::unique_ptr<Generator::Session> session;
+};
+
+static std::optional<Stream> stream{};
+
+float SpawnAheadTime(float bpm, float noteJumpSpeed, float noteJumpOffset) {
+    float beatDuration = 60 / bpm;
+    // halved until the jump is short enough, without a speed it stays at the longest
+    float halfJumpBeats = 4;
+    while (noteJumpSpeed * beatDuration * halfJumpBeats > 17.999f)
+        halfJumpBeats /= 2;
+    halfJumpBeats = std::max(halfJumpBeats + noteJumpOffset, 0.25f);
+    return 0.5f + halfJumpBeats * beatDuration;
+}
+
+// applies the edits that became final since the last time
+static void Publish() {
+    auto completed = stream->session->TakeCompleted();
+    bool empty = completed.rotations.empty() && completed.removedNotes.empty() && completed.mirroredNotes.empty() && completed.removedWalls.empty()
+        && completed.changedWalls.empty() && completed.generatedWalls.empty() && completed.splitWalls.empty();
+    if (!empty)
+        ApplyResult(stream->data.ptr(), completed, stream->noteObjects, stream->wallObjects, stream->stats.get(), &stream->nodes);
+}
+
+// caches the whole result like a normal generation
+static void Finish() {
+    auto result = stream->session->TakeResult();
+    getLogger().info("Finished streaming: %s", Generator::FormatStats(*stream->stats).c_str());
+
+    int diskCacheSize = getConfig().DiskCacheSize.GetValue();
+    if (diskCacheSize > 0) {
+        // in the background, the level is still playing
+        std::thread([key = stream->key, inputHash = stream->inputHash, result, directory = GetDiskCache().GetDirectory(), diskCacheSize]() {
+            Generator::DiskCache(directory, diskCacheSize * 1024 * 1024).Save(key, inputHash, result);
+        }).detach();
+    }
+    if (getConfig().CacheSize.GetValue() > 0)
+        GetResultCache().Insert(stream->key, stream->inputHash, std::move(result));
+
+    stream.reset();
+}
+
+void StartStreaming(BeatmapData* data, std::span<Generator::Note const> notes, std::span<Generator::Wall const> walls, Generator::Params const& params,
+        std::vector<NoteData*> noteObjects, std::vector<ObstacleData*> wallObjects, ItemNodes nodes, Generator::CacheKey key, uint64_t inputHash, float horizon, float spawnAheadTime) {
+    StopStreaming();
+
+    stream = Stream{data, std::move(noteObjects), std::move(wallObjects), std::move(nodes), std::move(key), inputHash, horizon, spawnAheadTime, std::make_unique<Generator::Stats>()};
+    stream->session = std::make_unique<Generator::Session>(notes, walls, params, stream->stats.get());
+
+    stream->session->Advance(notes.front().time + horizon);
+    stream->session->Finalize(spawnAheadTime + SpawnMargin);
+    Publish();
+    getLogger().info("Generated up to %.2f before the level starts", stream->session->GetCompletedTime());
+
+    if (stream->session->IsDone())
+        Finish();
+}
+
+void ContinueStreaming(float songTime) {
+    if (!stream)
+        return;
+
+    stream->session->Advance(songTime + stream->horizon, std::chrono::steady_clock::now() + FrameBudget);
+    // a wall longer than the horizon is only final once the bars past its end are decided
+    stream->session->Finalize(songTime + stream->spawnAheadTime + SpawnMargin);
+    Publish();
+
+    if (stream->session->IsDone())
+        Finish();
+}
+
+void StopStreaming() {
+    if (!stream)
+        return;
+
+    getLogger().info("Stopping unfinished stream at %.2f", stream->session->GetCompletedTime());
+    stream.reset();
+}